@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "state.h"
+#include "timer.h"
+
+// 100 seconds of game time
+const size_t DEFAULT_TICKS = 12000;
+const double NS_PER_S = 1e9;
+
+/**
+ * Runs the game as fast as possible without a display.
+ * Each tick is one fixed simulation step followed by drawing the frame, the
+ * same work emscripten_main does, except no time is spent waiting for vsync.
+ * The player is healed before every tick, like in bin/scenarios, so the run
+ * keeps timing the game scene instead of the game over screen. If the scene
+ * still changes, the run stops there and reports the ticks it managed.
+ *
+ * Usage: bin/bench [ticks]
+ */
+int main(int argc, char *argv[]) {
+  size_t requested_ticks =
+      argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_TICKS;
+
+  state_t *state = emscripten_init();
+  play(state);
+
+  player_t *player = game_get_player(state);
+  size_t full_health = player_get_health(player);
+  scene_t *scene = game_get_scene(state);
+
+  size_t ticks = 0;
+  double start = timer_now();
+  while (ticks < requested_ticks && scene_get_type(scene) == SCENE_GAME) {
+    player_set_health(player, full_health);
+    game_update(state, FIXED_DT);
+    game_render(state, 1.0);
+    ticks++;
+  }
+  double elapsed = timer_now() - start;
+
+  if (ticks < requested_ticks) {
+    printf("stopped early: left the game scene after %zu of %zu ticks\n",
+           ticks, requested_ticks);
+  }
+  printf("ticks: %zu\n", ticks);
+  printf("simulated: %.2f s\n", ticks * FIXED_DT);
+  printf("elapsed: %.3f s\n", elapsed);
+  // Without a tick there is no rate to report, only a division by zero
+  if (ticks > 0) {
+    printf("ticks per second: %.0f\n", ticks / elapsed);
+    printf("ns per tick: %.0f\n", elapsed * NS_PER_S / ticks);
+  }
+
+  // The process is about to exit, so the state is left for the OS to reclaim
+  return 0;
+}
@@ -0,0 +1,367 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "body.h"
+#include "collision.h"
+#include "enemy.h"
+#include "list.h"
+#include "polygon.h"
+#include "projectile.h"
+#include "timer.h"
+#include "vector.h"
+#include "vector_batch.h"
+
+/**
+ * Microbenchmarks for the vector, polygon, list and collision code.
+ *
+ * Prints one "<name> <ns per op>" line per benchmark, in a fixed order, after
+ * a "#" comment line describing the build. Saving that output gives a
+ * baseline file that a later run can be compared against:
+ *
+ *   bin/micro > baseline.txt
+ *   bin/micro --compare baseline.txt [--threshold 10]
+ *
+ * In compare mode, every benchmark that got slower by more than the threshold
+ * (in percent) is marked as a regression and the exit status is 1.
+ */
+
+// Every shape-dependent benchmark runs on regular polygons with these many
+// vertices: the quadrilateral hitboxes the game uses, and two larger shapes
+// (64 no longer fits in a vec_batch_t without allocating)
+const size_t SHAPE_SIZES[] = {4, 16, 64};
+const double SHAPE_RADIUS = 50;
+const size_t MELEE_RADIUS = 20;
+const double DODGE_RADIUS = 100;
+const double DODGE_SPEED = 150;
+
+// Each measurement repeats the operation until it takes at least this long,
+// and the fastest of MICRO_TRIALS measurements is reported
+const double MIN_TRIAL_TIME = 0.01;
+const size_t MICRO_TRIALS = 5;
+const size_t MICRO_START_ITERATIONS = 16;
+const double MICRO_NS_PER_S = 1e9;
+const double DEFAULT_THRESHOLD = 10;
+
+#define MICRO_NAME_SIZE 64
+#define MICRO_MAX_RESULTS 64
+
+typedef void (*micro_op_t)(void *aux, size_t iterations);
+
+typedef struct micro_result {
+  char name[MICRO_NAME_SIZE];
+  double ns_per_op;
+} micro_result_t;
+
+static micro_result_t results[MICRO_MAX_RESULTS];
+static size_t num_results = 0;
+
+/**
+ * Written to by every benchmark so the compiler can't drop the work.
+ */
+volatile scalar_t sink;
+
+/**
+ * Makes a regular polygon centered at the given point, counterclockwise.
+ */
+list_t *make_regular_polygon(size_t sides, vector_t center) {
+  list_t *points = list_init(sides, free);
+  for (size_t i = 0; i < sides; i++) {
+    double angle = 2 * M_PI * i / sides;
+    vector_t *point = malloc(sizeof(vector_t));
+    *point = (vector_t){.x = center.x + SHAPE_RADIUS * cos(angle),
+                        .y = center.y + SHAPE_RADIUS * sin(angle)};
+    list_add(points, point);
+  }
+  return points;
+}
+
+/**
+ * Times one benchmark and records its result under the given name.
+ */
+void micro_run(const char *name, micro_op_t op, void *aux) {
+  // Find an iteration count long enough to time reliably
+  size_t iterations = MICRO_START_ITERATIONS;
+  while (true) {
+    double start = timer_now();
+    op(aux, iterations);
+    if (timer_now() - start >= MIN_TRIAL_TIME) {
+      break;
+    }
+    iterations *= 2;
+  }
+
+  double best = INFINITY;
+  for (size_t trial = 0; trial < MICRO_TRIALS; trial++) {
+    double start = timer_now();
+    op(aux, iterations);
+    double elapsed = timer_now() - start;
+    best = elapsed < best ? elapsed : best;
+  }
+
+  assert(num_results < MICRO_MAX_RESULTS);
+  micro_result_t *result = &results[num_results++];
+  snprintf(result->name, MICRO_NAME_SIZE, "%s", name);
+  result->ns_per_op = best * MICRO_NS_PER_S / iterations;
+}
+
+void op_vec_rotate(void *aux, size_t iterations) {
+  vector_t v = {1, 2};
+  for (size_t i = 0; i < iterations; i++) {
+    v = vec_rotate(v, 0.01);
+  }
+  sink = v.x;
+}
+
+void op_polygon_centroid(void *aux, size_t iterations) {
+  scalar_t total = 0;
+  for (size_t i = 0; i < iterations; i++) {
+    total += polygon_centroid(aux).x;
+  }
+  sink = total;
+}
+
+void op_polygon_rotate(void *aux, size_t iterations) {
+  polygon_t *polygon = aux;
+  vector_t pivot = polygon_centroid(polygon);
+  for (size_t i = 0; i < iterations; i++) {
+    polygon_rotate(polygon, 0.01, pivot);
+  }
+  sink = ((vector_t *)list_get(polygon_get_points(polygon), 0))->x;
+}
+
+/**
+ * One op fills a list with aux's worth of items and then empties it from the
+ * front, the way the game removes bodies while iterating.
+ */
+void op_list_add_remove(void *aux, size_t iterations) {
+  size_t size = *(size_t *)aux;
+  list_t *list = list_init(1, NULL);
+  for (size_t i = 0; i < iterations; i++) {
+    for (size_t j = 0; j < size; j++) {
+      list_add(list, list);
+    }
+    while (list_size(list) > 0) {
+      list_remove(list, 0);
+    }
+  }
+  list_free(list);
+}
+
+void op_body_get_shape(void *aux, size_t iterations) {
+  size_t total = 0;
+  for (size_t i = 0; i < iterations; i++) {
+    list_t *shape = body_get_shape(aux);
+    total += list_size(shape);
+    list_free(shape);
+  }
+  sink = total;
+}
+
+typedef struct body_pair {
+  body_t *body1;
+  body_t *body2;
+} body_pair_t;
+
+void op_find_collision(void *aux, size_t iterations) {
+  body_pair_t *pair = aux;
+  size_t hits = 0;
+  for (size_t i = 0; i < iterations; i++) {
+    hits += find_collision(pair->body1, pair->body2).collided;
+  }
+  sink = hits;
+}
+
+void op_find_collision_melee(void *aux, size_t iterations) {
+  body_pair_t *pair = aux;
+  size_t hits = 0;
+  for (size_t i = 0; i < iterations; i++) {
+    hits +=
+        find_collision_melee(pair->body1, pair->body2, MELEE_RADIUS).collided;
+  }
+  sink = hits;
+}
+
+/**
+ * An enemy dodging a list of player projectiles spread around it, half of
+ * them within the dodge radius.
+ */
+typedef struct dodge_scene {
+  enemy_t *enemy;
+  body_t *player;
+  list_t *projectiles;
+} dodge_scene_t;
+
+dodge_scene_t make_dodge_scene(size_t num_projectiles) {
+  rgb_color_t color = {0, 0, 0};
+  dodge_scene_t scene = {
+      .enemy = enemy_init(1, VEC_ZERO, 0, 0),
+      .player = make_hitbox(20, 20, (vector_t){4 * DODGE_RADIUS, 0}, color),
+      .projectiles = list_init(num_projectiles, NULL),
+  };
+  for (size_t i = 0; i < num_projectiles; i++) {
+    double angle = 2 * M_PI * i / num_projectiles;
+    double distance = DODGE_RADIUS * (i % 2 == 0 ? 0.5 : 1.5);
+    vector_t position = {distance * cos(angle), distance * sin(angle)};
+    projectile_t *projectile = projectile_init(
+        1, 10, 5, position, color, PROJECTILE_PLAYER, angle * 180 / M_PI);
+    body_set_velocity(projectile_get_hitbox(projectile),
+                      (vector_t){-position.y, position.x});
+    list_add(scene.projectiles, projectile);
+  }
+  return scene;
+}
+
+void free_dodge_scene(dodge_scene_t *scene) {
+  for (size_t i = 0; i < list_size(scene->projectiles); i++) {
+    projectile_t *projectile = list_get(scene->projectiles, i);
+    body_free(projectile_get_hitbox(projectile));
+    projectile_free(projectile);
+  }
+  list_free(scene->projectiles);
+  body_free(enemy_get_hitbox(scene->enemy));
+  enemy_free(scene->enemy);
+  body_free(scene->player);
+}
+
+void op_enemy_dodge(void *aux, size_t iterations) {
+  dodge_scene_t *scene = aux;
+  for (size_t i = 0; i < iterations; i++) {
+    enemy_move_towards_player(scene->enemy, scene->player, scene->projectiles,
+                              0, 100, DODGE_SPEED, DODGE_RADIUS);
+  }
+  sink = body_get_velocity(enemy_get_hitbox(scene->enemy)).x;
+}
+
+void run_all(void) {
+  char name[MICRO_NAME_SIZE];
+  micro_run("vec_rotate", op_vec_rotate, NULL);
+
+  size_t num_sizes = sizeof(SHAPE_SIZES) / sizeof(SHAPE_SIZES[0]);
+  for (size_t i = 0; i < num_sizes; i++) {
+    size_t sides = SHAPE_SIZES[i];
+    vector_t origin = VEC_ZERO;
+
+    polygon_t *polygon = polygon_init(make_regular_polygon(sides, origin),
+                                      VEC_ZERO, 0, 0, 0, 0);
+    snprintf(name, sizeof(name), "polygon_centroid/%zu", sides);
+    micro_run(name, op_polygon_centroid, polygon);
+    snprintf(name, sizeof(name), "polygon_rotate/%zu", sides);
+    micro_run(name, op_polygon_rotate, polygon);
+    polygon_free(polygon);
+
+    snprintf(name, sizeof(name), "list_add_remove/%zu", sides);
+    micro_run(name, op_list_add_remove, &sides);
+
+    // Two shapes overlapping by half a radius, so every axis is tested
+    rgb_color_t color = {0, 0, 0};
+    body_pair_t pair = {
+        .body1 = body_init(make_regular_polygon(sides, origin), 1, color),
+        .body2 = body_init(
+            make_regular_polygon(sides, (vector_t){1.5 * SHAPE_RADIUS, 0}), 1,
+            color),
+    };
+    snprintf(name, sizeof(name), "body_get_shape/%zu", sides);
+    micro_run(name, op_body_get_shape, pair.body1);
+    snprintf(name, sizeof(name), "find_collision/%zu", sides);
+    micro_run(name, op_find_collision, &pair);
+    snprintf(name, sizeof(name), "find_collision_melee/%zu", sides);
+    micro_run(name, op_find_collision_melee, &pair);
+    body_free(pair.body1);
+    body_free(pair.body2);
+
+    dodge_scene_t dodge = make_dodge_scene(sides);
+    snprintf(name, sizeof(name), "enemy_dodge/%zu", sides);
+    micro_run(name, op_enemy_dodge, &dodge);
+    free_dodge_scene(&dodge);
+  }
+}
+
+/**
+ * Compares the results against a file written by an earlier run.
+ *
+ * @return the number of benchmarks that regressed beyond the threshold,
+ * or -1 if the baseline couldn't be read
+ */
+int compare(const char *baseline_path, double threshold) {
+  FILE *baseline = fopen(baseline_path, "r");
+  if (baseline == NULL) {
+    fprintf(stderr, "can't open baseline %s\n", baseline_path);
+    return -1;
+  }
+
+  micro_result_t old[MICRO_MAX_RESULTS];
+  size_t num_old = 0;
+  char line[2 * MICRO_NAME_SIZE];
+  while (num_old < MICRO_MAX_RESULTS && fgets(line, sizeof(line), baseline)) {
+    if (line[0] == '#') {
+      continue;
+    }
+    micro_result_t *entry = &old[num_old];
+    if (sscanf(line, "%63s %lf", entry->name, &entry->ns_per_op) == 2) {
+      num_old++;
+    }
+  }
+  fclose(baseline);
+
+  int regressions = 0;
+  printf("# %-30s %12s %12s %9s\n", "benchmark", "baseline", "current",
+         "change");
+  for (size_t i = 0; i < num_results; i++) {
+    micro_result_t *current = &results[i];
+    micro_result_t *previous = NULL;
+    for (size_t j = 0; j < num_old; j++) {
+      if (strcmp(old[j].name, current->name) == 0) {
+        previous = &old[j];
+        break;
+      }
+    }
+    if (previous == NULL) {
+      printf("%-32s %12s %12.2f %9s new\n", current->name, "-",
+             current->ns_per_op, "-");
+      continue;
+    }
+
+    double change =
+        (current->ns_per_op - previous->ns_per_op) / previous->ns_per_op * 100;
+    bool regressed = change > threshold;
+    regressions += regressed;
+    printf("%-32s %12.2f %12.2f %+8.1f%%%s\n", current->name,
+           previous->ns_per_op, current->ns_per_op, change,
+           regressed ? " REGRESSED" : "");
+  }
+  return regressions;
+}
+
+int main(int argc, char *argv[]) {
+  const char *baseline_path = NULL;
+  double threshold = DEFAULT_THRESHOLD;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+      baseline_path = argv[++i];
+    } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+      threshold = strtod(argv[++i], NULL);
+    } else {
+      fprintf(stderr, "usage: %s [--compare baseline] [--threshold percent]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  run_all();
+
+  if (baseline_path != NULL) {
+    int regressions = compare(baseline_path, threshold);
+    return regressions == 0 ? 0 : 1;
+  }
+
+  printf("# micro v1 scalar_t=%s vec_batch=%s\n",
+         sizeof(scalar_t) == sizeof(float) ? "float" : "double",
+         vec_batch_backend());
+  for (size_t i = 0; i < num_results; i++) {
+    printf("%s %.2f\n", results[i].name, results[i].ns_per_op);
+  }
+  return 0;
+}
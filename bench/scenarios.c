@@ -0,0 +1,266 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "state.h"
+#include "timer.h"
+#include "vector_batch.h"
+
+/**
+ * Repeatable workloads built directly from the game's own functions.
+ * Each scenario runs in a forked child so it starts from a fresh heap and
+ * game state, and reports its results to the parent through a pipe.
+ * The parent prints every result as a single JSON object on stdout.
+ *
+ * Usage: bin/scenarios [--seed S] [--ticks N]
+ *
+ * Must be linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc so
+ * allocations made by the game can be counted.
+ */
+
+const unsigned DEFAULT_SEED = 1;
+const double SCENARIO_NS_PER_S = 1e9;
+const size_t ENEMY_DAMAGE = 10;
+
+// Zombies chasing the player
+const size_t CHASE_ZOMBIES = 50;
+const size_t CHASE_TICKS = 2400;
+// Boss volleys kept topped up to this many bodies in the scene
+const size_t BOSS_BULLETS = 200;
+const size_t BOSS_TICKS = 2400;
+// The game has no numbered waves; one zombie spawns every ENEMY_SPAWN_TIME,
+// so the soak starts with the 20 zombies the game reaches by its 20th spawn
+const size_t SOAK_ZOMBIES = 20;
+const size_t SOAK_TICKS = 36000;
+
+typedef struct scenario_result {
+  size_t ticks;
+  double mean_ns;
+  double p50_ns;
+  double p99_ns;
+  double max_ns;
+  double allocs_per_tick;
+  size_t bodies;
+} scenario_result_t;
+
+typedef void (*scenario_setup_t)(state_t *state);
+typedef void (*scenario_step_t)(state_t *state);
+
+typedef struct scenario {
+  const char *name;
+  size_t ticks;
+  scenario_setup_t setup;
+  scenario_step_t step; // Runs before every tick, or NULL
+} scenario_t;
+
+/**
+ * The number of calls to malloc, calloc and realloc so far.
+ */
+static size_t allocations = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  allocations++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  allocations++;
+  return __real_realloc(ptr, size);
+}
+
+void chase_setup(state_t *state) {
+  for (size_t i = 0; i < CHASE_ZOMBIES; i++) {
+    spawn_enemy(state, ENEMY_DAMAGE);
+  }
+}
+
+void boss_setup(state_t *state) {
+  scene_set_type(game_get_scene(state), SCENE_BOSS);
+  spawn_boss(state);
+}
+
+void boss_step(state_t *state) {
+  // Fire another volley whenever bullets leave the screen
+  if (scene_bodies(game_get_scene(state)) < BOSS_BULLETS) {
+    render_boss_ring_attack(state);
+    render_boss_ray_attack(state);
+  }
+}
+
+void soak_setup(state_t *state) {
+  for (size_t i = 0; i < SOAK_ZOMBIES; i++) {
+    spawn_enemy(state, ENEMY_DAMAGE);
+  }
+}
+
+const scenario_t SCENARIOS[] = {
+    {.name = "zombie_chase", .ticks = CHASE_TICKS, .setup = chase_setup},
+    {.name = "boss_volley",
+     .ticks = BOSS_TICKS,
+     .setup = boss_setup,
+     .step = boss_step},
+    {.name = "soak_wave_20", .ticks = SOAK_TICKS, .setup = soak_setup},
+};
+
+int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Picks the nearest-rank percentile out of sorted samples: the smallest
+ * sample that at least a fraction p of the samples are less than or equal to.
+ */
+double percentile(double *sorted, size_t n, double p) {
+  size_t rank = (size_t)ceil(p * n);
+  if (rank < 1) {
+    rank = 1;
+  }
+  if (rank > n) {
+    rank = n;
+  }
+  return sorted[rank - 1];
+}
+
+/**
+ * Sets up and runs one scenario, timing each tick.
+ * Each tick is one game_update(FIXED_DT) plus one game_render, the same
+ * work emscripten_main does per step. The player is healed before every tick
+ * so the scenario can't end early in a game over. The scenario's own step is
+ * left out of both the timings and the allocation count, which cover exactly
+ * the same window.
+ */
+scenario_result_t scenario_run(const scenario_t *scenario, unsigned seed,
+                               size_t ticks) {
+  srand(seed);
+  state_t *state = emscripten_init();
+  play(state);
+  scenario->setup(state);
+
+  player_t *player = game_get_player(state);
+  size_t full_health = player_get_health(player);
+
+  double *samples = malloc(sizeof(double) * ticks);
+  size_t tick_allocations = 0;
+  double total = 0;
+  for (size_t i = 0; i < ticks; i++) {
+    player_set_health(player, full_health);
+    if (scenario->step != NULL) {
+      scenario->step(state);
+    }
+
+    size_t allocations_before = allocations;
+    double start = timer_now();
+    game_update(state, FIXED_DT);
+    game_render(state, 1.0);
+    samples[i] = (timer_now() - start) * SCENARIO_NS_PER_S;
+    tick_allocations += allocations - allocations_before;
+    total += samples[i];
+  }
+
+  qsort(samples, ticks, sizeof(double), compare_doubles);
+  scenario_result_t result = {
+      .ticks = ticks,
+      .mean_ns = total / ticks,
+      .p50_ns = percentile(samples, ticks, 0.50),
+      .p99_ns = percentile(samples, ticks, 0.99),
+      .max_ns = samples[ticks - 1],
+      .allocs_per_tick = (double)tick_allocations / ticks,
+      .bodies = scene_bodies(game_get_scene(state)),
+  };
+  free(samples);
+
+  // The child exits right away, so the game state is left for the OS
+  return result;
+}
+
+/**
+ * Runs a scenario in a child process and collects its result.
+ *
+ * @return true if the child ran the scenario to completion
+ */
+bool scenario_run_isolated(const scenario_t *scenario, unsigned seed,
+                           size_t ticks, scenario_result_t *result) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return false;
+  }
+
+  // The child inherits anything still buffered, and the game's log flushes
+  // stdout, so the JSON printed so far would be printed again
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    scenario_result_t child_result = scenario_run(scenario, seed, ticks);
+    ssize_t written = write(fds[1], &child_result, sizeof(child_result));
+    _exit(written == sizeof(child_result) ? 0 : 1);
+  }
+
+  close(fds[1]);
+  ssize_t got = read(fds[0], result, sizeof(*result));
+  close(fds[0]);
+  int status;
+  waitpid(pid, &status, 0);
+  return got == sizeof(*result) && WIFEXITED(status) &&
+         WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned seed = DEFAULT_SEED;
+  size_t ticks_override = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+      ticks_override = strtoul(argv[++i], NULL, 10);
+    } else {
+      fprintf(stderr, "usage: %s [--seed S] [--ticks N]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  size_t num_scenarios = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+  size_t reported = 0;
+  printf("{\n  \"seed\": %u,\n  \"vector_backend\": \"%s\",\n", seed,
+         vec_batch_backend());
+  printf("  \"scenarios\": [\n");
+  for (size_t i = 0; i < num_scenarios; i++) {
+    const scenario_t *scenario = &SCENARIOS[i];
+    size_t ticks = ticks_override > 0 ? ticks_override : scenario->ticks;
+
+    scenario_result_t result;
+    if (!scenario_run_isolated(scenario, seed, ticks, &result)) {
+      fprintf(stderr, "scenario %s failed\n", scenario->name);
+      continue;
+    }
+    printf("%s    {\"name\": \"%s\", \"ticks\": %zu, \"ns_per_tick\": %.0f, "
+           "\"p50_ns\": %.0f, \"p99_ns\": %.0f, \"max_ns\": %.0f, "
+           "\"allocs_per_tick\": %.2f, \"bodies\": %zu}",
+           reported > 0 ? ",\n" : "", scenario->name, result.ticks,
+           result.mean_ns, result.p50_ns, result.p99_ns, result.max_ns,
+           result.allocs_per_tick, result.bodies);
+    reported++;
+  }
+  printf("\n  ]\n}\n");
+
+  return reported == num_scenarios ? 0 : 1;
+}
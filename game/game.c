@@ -2,20 +2,31 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
 
 #include "asset.h"
 #include "asset_cache.h"
+#include "game.h"
 #include "sdl_wrapper.h"
 #include "player.h"
 #include "projectile.h" 
 #include "collision.h" 
+#include "flight_recorder.h"
+#include "hud.h"
+#include "layer_cache.h"
+#include "log.h"
 #include "forces.h" 
 #include "enemy.h"
 #include "boss.h"
 #include "portal.h"
+#include "perf_counters.h"
+#include "profiler.h"
+#include "profiler_overlay.h"
+#include "telemetry.h"
+#include "trace.h"
 
 // Movement speed constants
 const double H_STEP = 80;
@@ -52,7 +63,6 @@ const SDL_Rect XP_BAR = {.x = 425, .y = 10, .w = 150, .h = 23};
 const SDL_Rect BULLETS_BAR = {.x = 590, .y = 10, .w = 150, .h = 23};
 const SDL_Rect BOSS_BAR = {.x = (1000 - 30) / 2, .y = 290, .w = 30, .h = 5};
 const size_t BAR_MARGIN = 7;
-const size_t BAR_LIST_SIZE_INIT = 50;
 const char *XP_BAR_TEXT = "XP: %zu/%zu";
 const char *HP_BAR_TEXT = "HP: %zu/100";
 const char *BULLETS_BAR_TEXT = "Bullets: %zu/%zu";
@@ -88,6 +98,10 @@ const double BOSS_RAY_TIME = 5.0; // In seconds
 const size_t SPAWN_THRESHOLD = 20; // Enemies to kill before the boss spawns
 
 const double INIT_TIME = 1; // Starting representative clock time
+const double FIXED_DT = 1.0 / 120; // Length of one simulation step in seconds
+const size_t MAX_STEPS_PER_FRAME = 8; // Caps catch-up after a frame hitch
+const double STATIC_WAIT_TIME = 0.5; // Longest sleep on a static screen, in s
+const double ASSET_UPLOAD_BUDGET = 0.002; // Time per frame for texture uploads
 const size_t BODY_ASSETS = 4;
 
 const size_t NUM_BUTTONS = 2;
@@ -109,8 +123,14 @@ struct state {
     asset_t *win_screen;
     asset_t *play_button;
     asset_t *restart_button;
+    list_t *button_images; // The buttons don't own their images
     asset_t *overworld_image;
     asset_t *boss_background_image;
+    asset_t *interface_image;
+
+    hud_text_t *health_text;
+    hud_text_t *exp_text;
+    hud_text_t *bullets_text;
 
     bool boss_spawned;
     bool portal_spawned;
@@ -121,8 +141,36 @@ struct state {
     double time_since_boss_ring;
     double time_since_boss_ray;
     double time_since_cooldown_start;
+    double accumulator; // Real time not yet simulated, in seconds
+    scene_type_t drawn_scene; // Scene type shown by the last frame drawn
+
+    layer_cache_t *background_layer; // The background and boss health bar
+    layer_cache_t *hud_layer; // The player's bars and the interface border
 };
 
+/**
+ * Everything the HUD is drawn from, and the HUD layer's cache key.
+ * Filled in by get_hud_values().
+ */
+typedef struct hud_values {
+    size_t health;
+    size_t exp;
+    size_t level_scale;
+    size_t bullets_left;
+    size_t reload_seconds; // Only set while reloading
+    bool reloading;
+} hud_values_t;
+
+/**
+ * Everything the background layer is drawn from, and its cache key.
+ */
+typedef struct background_key {
+    scene_type_t scene;
+    asset_t *background; // NULL if no background is showing
+    bool boss_bar;
+    size_t boss_health; // Only set if boss_bar is
+} background_key_t;
+
 typedef struct button_info {
   const char *image_path;
   SDL_Rect image_box;
@@ -277,7 +325,7 @@ void on_mouse(mouse_event_type_t type, double x_loc, double y_loc, state_t *stat
  * @param force_const the force constant for the collision (unused)
 */
 void player_projectile_collision_handler(body_t *player_body, body_t *projectile_body, 
-                                         vector_t axis, void *aux, double force_const) {
+                                         vector_t axis, void *aux, scalar_t force_const) {
     // Get the player and projectile structures
     player_t *player = body_get_info(player_body);
     projectile_t *projectile = body_get_info(projectile_body);
@@ -304,7 +352,7 @@ void player_projectile_collision_handler(body_t *player_body, body_t *projectile
  * @param force_const the force constant for the collision (unused)
 */
 void enemy_projectile_collision_handler(body_t *enemy_body, body_t *projectile_body, 
-                                        vector_t axis, void *aux, double force_const) {
+                                        vector_t axis, void *aux, scalar_t force_const) {
     body_remove(projectile_body);
     body_remove(enemy_body);
 }
@@ -319,7 +367,7 @@ void enemy_projectile_collision_handler(body_t *enemy_body, body_t *projectile_b
  * @param force_const the force constant for the collision (unused)
 */
 void boss_projectile_collision_handler(body_t *boss_body, body_t *projectile_body, 
-                                       vector_t axis, void *aux, double force_const) {
+                                       vector_t axis, void *aux, scalar_t force_const) {
     boss_t *current_boss = body_get_info(boss_body);
 
     size_t current_boss_health = boss_get_health(current_boss);
@@ -344,7 +392,7 @@ void boss_projectile_collision_handler(body_t *boss_body, body_t *projectile_bod
  * @param force_const the force constant for the collision (unused)
 */
 void portal_handler(body_t *player_body, body_t *portal_body, vector_t axis, void *aux, 
-                    double force_const) {
+                    scalar_t force_const) {
     collision_info_t info = find_collision(portal_body, player_body);
     if (info.collided) {
         portal_t *portal = body_get_info(portal_body);
@@ -374,6 +422,7 @@ void render_player_ranged_attack(state_t *state, vector_t mouse_loc) {
                                          sdl_get_bounding_box(laser_body), 
                                          laser_body, 
                                          -1 * projectile_get_angle(projectile));
+        asset_set_layer(laser_image, LAYER_PROJECTILES);
         list_add(state->body_assets, laser_image);
 
         // Make collisions with every existing enemy
@@ -438,6 +487,7 @@ void render_enemy_attack(state_t *state, enemy_t *enemy) {
     asset_t *laser_image = 
     asset_make_image_with_body_angle(ENEMY_BULLET_PATH, sdl_get_bounding_box(laser_body), 
                                      laser_body, -projectile_get_angle(projectile)); 
+    asset_set_layer(laser_image, LAYER_PROJECTILES);
     list_add(state->body_assets, laser_image);
 
     create_collision(state->scene, player_body, laser_body, 
@@ -468,6 +518,7 @@ void render_boss_ring_attack(state_t *state) {
                                          sdl_get_bounding_box(laser_body), 
                                          laser_body, 
                                          -1 * projectile_get_angle(projectile)); 
+        asset_set_layer(laser_image, LAYER_PROJECTILES);
         list_add(state->body_assets, laser_image);
 
         create_collision(state->scene, player_body, laser_body, 
@@ -496,6 +547,7 @@ void render_boss_ray_attack(state_t *state) {
         asset_t *laser_image = 
         asset_make_image_with_body_angle(HUSKY_RAY_PATH, sdl_get_bounding_box(laser_body), 
                                          laser_body, -projectile_get_angle(projectile)); 
+        asset_set_layer(laser_image, LAYER_PROJECTILES);
         list_add(state->body_assets, laser_image);
 
         create_collision(state->scene, player_body, laser_body, 
@@ -518,6 +570,8 @@ void spawn_boss(state_t *state) {
     asset_make_image_with_body(HUSKY_PATH, sdl_get_bounding_box(boss_body), boss_body);
     list_add(state->body_assets, boss_image);
     state->boss = boss;
+    state->boss_spawned = true;
+    TRACE_INSTANT("spawn_boss");
 }
 
 /**
@@ -559,6 +613,145 @@ void spawn_enemy(state_t *state, size_t damage) {
     }
 }
 
+/**
+ * Starts decoding the images a scene draws in the background, so switching
+ * to it doesn't stall on loading them. Called as soon as the switch becomes
+ * possible; images that are already loaded or on their way are skipped.
+ * The buttons are left out since they are made in emscripten_init.
+ * 
+ * @param scene_type the scene that may come next
+*/
+void preload_scene(scene_type_t scene_type) {
+    switch (scene_type) {
+        case SCENE_MENU: {
+            asset_cache_prefetch(STARTSCREEN_PATH);
+            break;
+        }
+        case SCENE_GAME: {
+            asset_cache_prefetch(OVERWORLD_PATH);
+            asset_cache_prefetch(INTERFACE_PATH);
+            asset_cache_prefetch(PLAYER_PATH);
+            asset_cache_prefetch(PLAYER_BULLET_PATH);
+            asset_cache_prefetch(ENEMY_PATH);
+            asset_cache_prefetch(ENEMY_BULLET_PATH);
+            asset_cache_prefetch(PORTAL_PATH_BOSS);
+            break;
+        }
+        case SCENE_BOSS: {
+            asset_cache_prefetch(BOSS_BACKGROUND_PATH);
+            asset_cache_prefetch(HUSKY_PATH);
+            asset_cache_prefetch(HUSKY_BULLET_PATH);
+            asset_cache_prefetch(HUSKY_RAY_PATH);
+            asset_cache_prefetch(PORTAL_PATH_END);
+            break;
+        }
+        case SCENE_GAME_OVER_WIN: {
+            asset_cache_prefetch(WINSCREEN_PATH);
+            break;
+        }
+        case SCENE_GAME_OVER_LOSS: {
+            asset_cache_prefetch(DEATHSCREEN_PATH);
+            break;
+        }
+    }
+}
+
+/**
+ * Makes a full-screen image for a scene and stores it in `image`, unless
+ * there already is one.
+ * 
+ * @param image where the state keeps the image
+ * @param path the path to the image
+ * @param layer the layer to draw the image on
+*/
+void make_scene_image(asset_t **image, const char *path, render_layer_t layer) {
+    if (*image != NULL) {
+        return;
+    }
+    SDL_Rect background_box = {.x = MIN.x, .y = MIN.y, .w = MAX.x, .h = MAX.y};
+    *image = asset_make_image(path, background_box);
+    asset_set_layer(*image, layer);
+}
+
+/**
+ * Destroys a full-screen image of a scene, if there is one, so the asset
+ * cache can free its texture once it is over its budget or purged.
+ * 
+ * @param image where the state keeps the image
+*/
+void destroy_scene_image(asset_t **image) {
+    asset_destroy(*image);
+    *image = NULL;
+}
+
+/**
+ * Switches to another scene. The full-screen images only the other scenes
+ * draw are destroyed, and the next scene's are made again if an earlier
+ * switch destroyed them, so the backgrounds of every scene aren't held at
+ * once. Destroying an image only releases it; the asset cache's budget
+ * decides when its texture is actually freed.
+ * 
+ * @param state the current state of the game
+ * @param scene_type the scene to switch to
+*/
+void switch_scene(state_t *state, scene_type_t scene_type) {
+    bool in_world = scene_type == SCENE_GAME || scene_type == SCENE_BOSS;
+    if (scene_type != SCENE_MENU) {
+        destroy_scene_image(&state->start_screen);
+    }
+    if (scene_type != SCENE_GAME) {
+        destroy_scene_image(&state->overworld_image);
+    }
+    if (scene_type != SCENE_BOSS) {
+        destroy_scene_image(&state->boss_background_image);
+    }
+    if (!in_world) {
+        destroy_scene_image(&state->interface_image);
+    }
+    if (scene_type != SCENE_GAME_OVER_LOSS) {
+        destroy_scene_image(&state->lose_screen);
+    }
+    if (scene_type != SCENE_GAME_OVER_WIN) {
+        destroy_scene_image(&state->win_screen);
+    }
+
+    switch (scene_type) {
+        case SCENE_MENU: {
+            make_scene_image(&state->start_screen, STARTSCREEN_PATH, 
+                             LAYER_BACKGROUND);
+            break;
+        }
+        case SCENE_GAME: {
+            make_scene_image(&state->overworld_image, OVERWORLD_PATH, 
+                             LAYER_BACKGROUND);
+            break;
+        }
+        case SCENE_BOSS: {
+            make_scene_image(&state->boss_background_image, BOSS_BACKGROUND_PATH, 
+                             LAYER_BACKGROUND);
+            break;
+        }
+        case SCENE_GAME_OVER_LOSS: {
+            make_scene_image(&state->lose_screen, DEATHSCREEN_PATH, LAYER_OVERLAY);
+            break;
+        }
+        case SCENE_GAME_OVER_WIN: {
+            make_scene_image(&state->win_screen, WINSCREEN_PATH, LAYER_OVERLAY);
+            break;
+        }
+    }
+    if (in_world) {
+        make_scene_image(&state->interface_image, INTERFACE_PATH, LAYER_HUD);
+    }
+    if (scene_type == SCENE_GAME_OVER_LOSS || scene_type == SCENE_GAME_OVER_WIN) {
+        // Restarting leads back to the menu and the game, whose images the
+        // budget may have evicted by now
+        preload_scene(SCENE_MENU);
+        preload_scene(SCENE_GAME);
+    }
+    scene_set_type(state->scene, scene_type);
+}
+
 /**
  * Spawns a portal at the center of the screen
  * 
@@ -566,6 +759,7 @@ void spawn_enemy(state_t *state, size_t damage) {
  * @param type the type of portal to spawn (END GAME OR BOSS ROOM)
 */
 void spawn_portal(state_t *state, portal_type_t type) {
+    TRACE_INSTANT("spawn_portal");
     portal_t *portal = portal_init((vector_t){MAX.x / 2, MAX.y / 2}, type);
     body_t *portal_body = portal_get_hitbox(portal);
     body_set_info(portal_body, portal);
@@ -573,6 +767,8 @@ void spawn_portal(state_t *state, portal_type_t type) {
     asset_t *portal_image = NULL;
     switch (type) {
         case PORTAL_BOSS: {
+            // The player is about to walk into the boss room
+            preload_scene(SCENE_BOSS);
             portal_image = 
             asset_make_image_with_body(PORTAL_PATH_BOSS, 
             sdl_get_bounding_box(portal_body), 
@@ -580,6 +776,7 @@ void spawn_portal(state_t *state, portal_type_t type) {
             break;
         }
         case PORTAL_END: {
+            preload_scene(SCENE_GAME_OVER_WIN);
             portal_image = 
             asset_make_image_with_body(PORTAL_PATH_END, sdl_get_bounding_box(portal_body), 
                                        portal_body);
@@ -595,63 +792,70 @@ void spawn_portal(state_t *state, portal_type_t type) {
 }
 
 /**
- * Renders the health bars, exp bars, level bars, and projectile load bars on screen. 
- * 
+ * Gets the values the HUD shows.
+ *
  * @param state the current state of the game
+ * @return the values, with any padding zeroed so they can be compared bytewise
 */
-void render_bars(state_t *state) {
-    size_t current_health = player_get_health(state->player);
-    size_t current_exp = player_get_exp(state->player);
-    size_t current_level_scale = player_get_level_scale(state->player);
-
-    sdl_draw_bar(current_health, PLAYER_MAX_HEALTH, HP_BAR, GREEN, RED);
-    sdl_draw_bar(current_exp, current_level_scale, XP_BAR, PURPLE, GREY);
-
-    char health_text[BAR_LIST_SIZE_INIT];
-    sprintf(health_text, HP_BAR_TEXT, current_health);
-    SDL_Rect health_text_rect = {
-        .x = HP_BAR.x + BAR_MARGIN, 
-        .y = HP_BAR.y + BAR_MARGIN / 2, // 2 to center vertically
-        .w = HP_BAR.w - 2 * BAR_MARGIN, 
-        .h = TTF_FontHeight(state->font) - (2 * BAR_MARGIN)
-    };
-    sdl_render_text_color(health_text, state->font, health_text_rect, WHTE);
-
-    // text for XP bar
-    char exp_text[BAR_LIST_SIZE_INIT];
-    sprintf(exp_text, XP_BAR_TEXT, current_exp, current_level_scale);
-    SDL_Rect exp_text_rect = {
-        .x = XP_BAR.x + BAR_MARGIN, 
-        .y = XP_BAR.y + BAR_MARGIN / 2, // 2 to center vertically
-        .w = XP_BAR.w - 2 * BAR_MARGIN, 
-        .h = TTF_FontHeight(state->font) - (2 * BAR_MARGIN)
-    };
-    sdl_render_text_color(exp_text, state->font, exp_text_rect, WHTE);
+hud_values_t get_hud_values(state_t *state) {
+    hud_values_t values;
+    memset(&values, 0, sizeof(values));
+    values.health = player_get_health(state->player);
+    values.exp = player_get_exp(state->player);
+    values.level_scale = player_get_level_scale(state->player);
 
     // Calculate the bullets left and whether the player is in cooldown
-    size_t bullets_left = 
+    values.bullets_left = 
     PLAYER_MAX_BULLETS - (state->bullets_fired % (size_t)PLAYER_MAX_BULLETS);
-    sdl_draw_bar(bullets_left, PLAYER_MAX_BULLETS, BULLETS_BAR, BLUE, GREY);
+    values.reloading = !(state->bullets_fired < (size_t)PLAYER_MAX_BULLETS && 
+                         state->time_since_cooldown_start >= PLAYER_BULLET_COOLDOWN);
+    if (values.reloading) {
+        values.reload_seconds = 
+        (size_t)ceil(PLAYER_BULLET_COOLDOWN - state->time_since_cooldown_start);
+    }
+    return values;
+}
 
-    char bullets_text[BAR_LIST_SIZE_INIT];
-    if (state->bullets_fired < (size_t)PLAYER_MAX_BULLETS && 
-        state->time_since_cooldown_start >= PLAYER_BULLET_COOLDOWN) {
-        sprintf(bullets_text, BULLETS_BAR_TEXT, bullets_left, (size_t)PLAYER_MAX_BULLETS);
+/**
+ * Renders the health bars, exp bars, level bars, and projectile load bars on screen. 
+ * 
+ * @param state the current state of the game
+ * @param values the values to show, from get_hud_values()
+*/
+void render_bars(state_t *state, const hud_values_t *values) {
+    PROFILE_BEGIN(PROFILE_RENDER_BARS);
+    sdl_draw_bar(values->health, PLAYER_MAX_HEALTH, HP_BAR, GREEN, RED);
+    hud_text_set(state->health_text, HP_BAR_TEXT, values->health);
+    hud_text_render(state->health_text);
 
+    // text for XP bar
+    sdl_draw_bar(values->exp, values->level_scale, XP_BAR, PURPLE, GREY);
+    hud_text_set(state->exp_text, XP_BAR_TEXT, values->exp, values->level_scale);
+    hud_text_render(state->exp_text);
+
+    sdl_draw_bar(values->bullets_left, PLAYER_MAX_BULLETS, BULLETS_BAR, BLUE, GREY);
+    if (!values->reloading) {
+        hud_text_set(state->bullets_text, BULLETS_BAR_TEXT, values->bullets_left, 
+                     (size_t)PLAYER_MAX_BULLETS);
     } else {
-        size_t remaining_cooldown = 
-        (size_t)ceil(PLAYER_BULLET_COOLDOWN - state->time_since_cooldown_start);
-        sprintf(bullets_text, RELOAD_BAR_TEXT, remaining_cooldown);
+        hud_text_set(state->bullets_text, RELOAD_BAR_TEXT, values->reload_seconds);
     }
-    SDL_Rect bullets_text_rect = {
-        .x = BULLETS_BAR.x + BAR_MARGIN, 
-        .y = BULLETS_BAR.y + BAR_MARGIN / 2, //2 to center verticalluy
-        .w = BULLETS_BAR.w - 2 * BAR_MARGIN, 
-        .h = TTF_FontHeight(state->font) - (2 * BAR_MARGIN)
-    };
-    sdl_render_text_color(bullets_text, state->font, bullets_text_rect, WHTE);
+    hud_text_render(state->bullets_text);
+    PROFILE_END(PROFILE_RENDER_BARS);
 }
 
+/**
+ * Gets where a bar's text goes, inside the bar's left end.
+ * 
+ * @param bar the bar's rectangle
+ * @return the position of the text
+*/
+SDL_Rect bar_text_position(SDL_Rect bar) {
+    return (SDL_Rect){
+        .x = bar.x + BAR_MARGIN, 
+        .y = bar.y + BAR_MARGIN / 2 // 2 to center vertically
+    };
+}
 
 /**
  * Renders the border of our interface
@@ -659,10 +863,58 @@ void render_bars(state_t *state) {
  * @param state the current state of the game
 */
 void render_interface_border(state_t *state) {
-    SDL_Rect interface_box = {.x = MIN.x, .y = MIN.y, .w = MAX.x, .h = MAX.y};
-    asset_t *interface_image = asset_make_image(INTERFACE_PATH, interface_box);
-    list_add(state->body_assets, interface_image);
-    asset_render(interface_image);
+    asset_render(state->interface_image);
+}
+
+/**
+ * Renders the HUD from its layer cache, redrawing the cached layer only if
+ * the values it shows have changed.
+ * 
+ * @param state the current state of the game
+*/
+void render_hud(state_t *state) {
+    hud_values_t values = get_hud_values(state);
+    if (layer_cache_begin(state->hud_layer, &values, sizeof(values))) {
+        render_bars(state, &values);
+        render_interface_border(state);
+        layer_cache_end(state->hud_layer);
+    }
+    layer_cache_draw(state->hud_layer);
+}
+
+/**
+ * Renders the background of the game or boss scene, and the boss's health
+ * bar, from the background layer cache.
+ * 
+ * @param state the current state of the game
+*/
+void render_background(state_t *state) {
+    background_key_t key;
+    memset(&key, 0, sizeof(key));
+    key.scene = scene_get_type(state->scene);
+    if (key.scene == SCENE_GAME) {
+        if (!state->game_over && 
+            (state->enemies_killed < SPAWN_THRESHOLD || state->portal_spawned)) {
+            key.background = state->overworld_image;
+        }
+    } else if (!state->game_over || state->portal_spawned) {
+        key.background = state->boss_background_image;
+        key.boss_bar = state->boss_spawned && boss_get_health(state->boss);
+        if (key.boss_bar) {
+            key.boss_health = boss_get_health(state->boss);
+        }
+    }
+
+    if (layer_cache_begin(state->background_layer, &key, sizeof(key))) {
+        if (key.background != NULL) {
+            asset_render(key.background);
+        }
+        if (key.boss_bar) {
+            sdl_draw_bar(key.boss_health, MAX_BOSS_HEALTH, BOSS_BAR, GREEN, RED);
+        }
+        layer_cache_end(state->background_layer);
+    }
+    layer_cache_draw(state->background_layer);
 }
 
 /**
@@ -691,6 +943,7 @@ void clear_screen(state_t *state) {
  * @param state the current state of the game
 */
 void clear_enemies(state_t *state) {
+    PROFILE_BEGIN(PROFILE_CLEAR_ENEMIES);
     for (size_t i = 0; i < list_size(state->enemies); i++) {
         enemy_t *enemy = list_get(state->enemies, i);
         if (body_is_removed(enemy_get_hitbox(enemy))) {
@@ -713,6 +966,7 @@ void clear_enemies(state_t *state) {
             }
         }
     }
+    PROFILE_END(PROFILE_CLEAR_ENEMIES);
 }
 
 
@@ -732,28 +986,37 @@ void clear_projectiles(state_t *state) {
 }
 
 /**
- * Renders all the assets on screen
+ * Destroys the assets whose bodies have been marked for removal. Must run
+ * before scene_tick() frees those bodies.
  * 
  * @param state the current state of the game
 */
-void render_assets(state_t *state) {
+void clear_assets(state_t *state) {
     for (size_t i = 0; i < list_size(state->body_assets); i++) {
         asset_t *asset = list_get(state->body_assets, i);
-        bool render = true;
         if (asset_get_type(asset) == ASSET_IMAGE) {
             body_t *body = asset_get_body(asset);
             
             if (body && body_is_removed(body)) {
-                render = false;
                 asset_destroy(list_remove(state->body_assets, i));
                 i -= 1;
             }
         }
+    }
+}
 
-        if (render) {
-            asset_render(asset);
-        }
+/**
+ * Renders all the assets on screen
+ * 
+ * @param state the current state of the game
+ * @param alpha how far between the last two simulation steps to draw bodies
+*/
+void render_assets(state_t *state, double alpha) {
+    PROFILE_BEGIN(PROFILE_RENDER_ASSETS);
+    for (size_t i = 0; i < list_size(state->body_assets); i++) {
+        asset_render_interpolated(list_get(state->body_assets, i), alpha);
     }
+    PROFILE_END(PROFILE_RENDER_ASSETS);
 }
 
 /**
@@ -762,7 +1025,7 @@ void render_assets(state_t *state) {
  * @param state the current state of the game
 */
 void play(state_t *state) {
-    scene_set_type(state->scene, SCENE_GAME);
+    switch_scene(state, SCENE_GAME);
 }
 
 /**
@@ -771,7 +1034,27 @@ void play(state_t *state) {
  * @param state the current state of the game
 */
 void restart(state_t *state) {
-    scene_set_type(state->scene, SCENE_MENU);
+    switch_scene(state, SCENE_MENU);
+}
+
+/**
+ * Gets the player of the game
+ * 
+ * @param state the current state of the game
+ * @return the player
+*/
+player_t *game_get_player(state_t *state) {
+    return state->player;
+}
+
+/**
+ * Gets the scene holding every body in the game
+ * 
+ * @param state the current state of the game
+ * @return the scene
+*/
+scene_t *game_get_scene(state_t *state) {
+    return state->scene;
 }
 
 // Image and location mapping for the buttons
@@ -794,6 +1077,8 @@ asset_t *create_button_from_info(state_t *state, button_info_t info) {
 
   if (info.image_path != NULL) {
     current_image = asset_make_image(info.image_path, info.image_box);
+    asset_set_layer(current_image, LAYER_HUD);
+    list_add(state->button_images, current_image);
   }
 
   asset_t *current_button = asset_make_button(info.image_box, current_image,
@@ -821,6 +1106,11 @@ void create_buttons(state_t *state) {
 }
 
 state_t *emscripten_init() {
+    log_init();
+    TRACE_INIT();
+    PERF_INIT();
+    TELEMETRY_INIT();
+
     // Initialize the asset cache and SDL
     asset_cache_init();
     sdl_init(MIN, MAX);
@@ -833,7 +1123,13 @@ state_t *emscripten_init() {
     state->scene = scene_init();
     scene_set_type(state->scene, SCENE_MENU);
     state->body_assets = list_init(BODY_ASSETS, (free_func_t) asset_destroy);
-    state->font = TTF_OpenFont(FONT_PATH, TEXT_SIZE);
+    state->font = load_font(FONT_PATH, TEXT_SIZE);
+    state->background_layer = layer_cache_init();
+    state->hud_layer = layer_cache_init();
+    state->health_text = hud_text_init(state->font, bar_text_position(HP_BAR), WHTE);
+    state->exp_text = hud_text_init(state->font, bar_text_position(XP_BAR), WHTE);
+    state->bullets_text = hud_text_init(state->font, bar_text_position(BULLETS_BAR), 
+                                        WHTE);
 
     // Start the spawn and attack timers/counters at 0
     state->time_since_spawn = 0.0;
@@ -842,14 +1138,17 @@ state_t *emscripten_init() {
     state->time_since_boss_ray = 0.0;
     state->bullets_fired = 0.0;
     state->time_since_cooldown_start = PLAYER_BULLET_COOLDOWN;
+    state->accumulator = 0.0;
+    state->drawn_scene = SCENE_MENU;
     state->enemies_killed = 0;
     state->boss_spawned = false;
     state->portal_spawned = false;
     state->game_over = false;
     state->boss = NULL;
+    state->portal = NULL;
 
     // Create the buttons for the menu and the end screen.
-    asset_cache_init();
+    state->button_images = list_init(NUM_BUTTONS, (free_func_t) asset_destroy);
     create_buttons(state);
 
     // Initialize the list of projectiles and enemies
@@ -863,24 +1162,25 @@ state_t *emscripten_init() {
     body_set_info(player_body, state->player); // Store the player_t pointer in info field
     scene_add_body(state->scene, player_body);
 
-    // Create the images for all necessary backgrounds and add it to the body assets
-    SDL_Rect background_box = {.x = MIN.x, .y = MIN.y, .w = MAX.x, .h = MAX.y};
-
-    asset_t *startscreen_image = asset_make_image(STARTSCREEN_PATH, background_box);
-    state->start_screen = startscreen_image;
-
-    asset_t *overworld_image = asset_make_image(OVERWORLD_PATH, background_box);
-    state->overworld_image = overworld_image;
-    
-    asset_t *boss_background_image = asset_make_image(BOSS_BACKGROUND_PATH, 
-                                                      background_box);
-    state->boss_background_image = boss_background_image;
-
-    asset_t *death_overlay_image = asset_make_image(DEATHSCREEN_PATH, background_box);
-    state->lose_screen = death_overlay_image;
-
-    asset_t *win_overlay_image = asset_make_image(WINSCREEN_PATH, background_box);
-    state->win_screen = win_overlay_image;
+    // Decode what the menu and the game draw on the asset cache's threads
+    // rather than one by one before the first frame or at the first spawn.
+    // Every background is started now too, though each is only made once its
+    // scene starts; the rest of the boss room waits until its portal appears.
+    preload_scene(SCENE_MENU);
+    preload_scene(SCENE_GAME);
+    preload_scene(SCENE_GAME_OVER_LOSS);
+    preload_scene(SCENE_GAME_OVER_WIN);
+    asset_cache_prefetch(BOSS_BACKGROUND_PATH);
+
+    // Only the menu's images are made now; every other scene makes its own
+    // when it starts and destroys them when it ends
+    state->start_screen = NULL;
+    state->overworld_image = NULL;
+    state->boss_background_image = NULL;
+    state->lose_screen = NULL;
+    state->win_screen = NULL;
+    state->interface_image = NULL;
+    switch_scene(state, SCENE_MENU);
 
     // Create the player image and add it to the body assets
     asset_t *player_image = 
@@ -895,27 +1195,24 @@ state_t *emscripten_init() {
     return state;
 }
 
-bool emscripten_main(state_t *state) {
+/**
+ * Advances the game by one fixed simulation step.
+ * 
+ * @param state the current state of the game
+ * @param dt the length of the step in seconds
+*/
+void game_update(state_t *state, double dt) {
     switch (scene_get_type(state->scene)) {
         case SCENE_MENU: {
-            sdl_clear();
-            double dt = time_since_last_tick();
-
-            asset_render(state->start_screen);
-            asset_render(state->play_button);
-
-            sdl_show();
             scene_tick(state->scene, dt);
-            return false;
+            break;
         }
         case SCENE_GAME: {
-            double dt = time_since_last_tick();
-
             if (player_get_health(state->player) <= 0) {
                 clear_screen(state);
                 state->game_over = true;
-                scene_set_type(state->scene, SCENE_GAME_OVER_LOSS);
-                return false;
+                switch_scene(state, SCENE_GAME_OVER_LOSS);
+                return;
             }
             else {
                 if (state->enemies_killed < SPAWN_THRESHOLD) {
@@ -951,8 +1248,7 @@ bool emscripten_main(state_t *state) {
                 } 
                 else {
                     if (!portal_get_status(state->portal)) {
-                        asset_destroy(state->overworld_image);
-                        scene_set_type(state->scene, SCENE_BOSS);
+                        switch_scene(state, SCENE_BOSS);
                         state->portal_spawned = false;
                     }
                 }
@@ -964,51 +1260,30 @@ bool emscripten_main(state_t *state) {
                 clear_screen(state);
             }
 
-            sdl_clear();
-
-            if (!state->game_over) {
-                if (state->enemies_killed < SPAWN_THRESHOLD || state->portal_spawned) {
-                    asset_render(state->overworld_image);
-                }
-            }
-
             // Clean up super-class objects for projectiles and enemies
             clear_projectiles(state);
-            
             clear_enemies(state);
+            clear_assets(state);
 
-            render_assets(state);
-
-            if (!state->game_over) {
-                render_bars(state);
-                render_interface_border(state);
-            }
-
-            sdl_show();
             scene_tick(state->scene, dt);
-            
-            return false;
+            break;
         }
         case SCENE_BOSS: {
-            double dt = time_since_last_tick();
             if (!state->boss_spawned && state->enemies_killed >= SPAWN_THRESHOLD) {
                 body_t *player_body = player_get_hitbox(state->player);
                 body_set_centroid(player_body, RESET_POS);
                 spawn_boss(state);
-                state->boss_spawned = true;
             }
             
             if (player_get_health(state->player) <= 0) {
-                asset_destroy(state->boss_background_image);
+                switch_scene(state, SCENE_GAME_OVER_LOSS);
                 body_t *player_body = player_get_hitbox(state->player);
                 body_remove(player_body);
                 body_t *boss_body = boss_get_hitbox(state->boss);
                 body_remove(boss_body);
 
                 state->game_over = true;
-            
-                scene_set_type(state->scene, SCENE_GAME_OVER_LOSS);
-                return false;
+                return;
             }
             else if (boss_get_health(state->boss) <= 0) {
                 if (!state->portal_spawned) {
@@ -1018,15 +1293,13 @@ bool emscripten_main(state_t *state) {
                     state->portal_spawned = true;
                 }
                 if (!portal_get_status(state->portal)) {
-                    asset_destroy(state->boss_background_image);
+                    switch_scene(state, SCENE_GAME_OVER_WIN);
                     body_t *player_body = player_get_hitbox(state->player);
                     body_remove(player_body);
 
                     state->game_over = true;
                     state->portal_spawned = false;
-
-                    scene_set_type(state->scene, SCENE_GAME_OVER_WIN);
-                    return false;
+                    return;
                 }
             }
             else {
@@ -1079,71 +1352,213 @@ bool emscripten_main(state_t *state) {
                 clear_screen(state);
             }
 
-            sdl_clear();
+            // Clean up super-class objects for projectiles and enemies
+            clear_projectiles(state);
+            clear_enemies(state);
+            clear_assets(state);
 
+            scene_tick(state->scene, dt);
+            break;
+        }
+        case SCENE_GAME_OVER_LOSS:
+        case SCENE_GAME_OVER_WIN: {
+            break;
+        }
+    }
+}
 
-            if (!state->game_over || state->portal_spawned) {
-                asset_render(state->boss_background_image);
+/**
+ * Draws the current frame.
+ * 
+ * @param state the current state of the game
+ * @param alpha how far between the last two simulation steps to draw bodies,
+ * from 0 (previous step) to 1 (latest step)
+*/
+void game_render(state_t *state, double alpha) {
+    switch (scene_get_type(state->scene)) {
+        case SCENE_MENU: {
+            sdl_clear();
+            asset_render(state->start_screen);
+            asset_render(state->play_button);
+            sdl_show();
+            break;
+        }
+        case SCENE_GAME: {
+            sdl_clear();
+            render_background(state);
+            render_assets(state, alpha);
 
-                if (state->boss_spawned && boss_get_health(state->boss)) {
-                    sdl_draw_bar(boss_get_health(state->boss), MAX_BOSS_HEALTH, BOSS_BAR, 
-                                GREEN, RED);
-                }   
+            if (!state->game_over) {
+                render_hud(state);
             }
 
-            // Clean up super-class objects for projectiles and enemies
-            clear_projectiles(state);
-            clear_enemies(state);
-            
-            render_assets(state);
+            PROFILE_OVERLAY(state->font);
+            sdl_show();
+            break;
+        }
+        case SCENE_BOSS: {
+            sdl_clear();
+            render_background(state);
+            render_assets(state, alpha);
 
             if (!state->game_over) {
-                render_bars(state);
-                render_interface_border(state);
+                render_hud(state);
             }
 
+            PROFILE_OVERLAY(state->font);
             sdl_show();
-            scene_tick(state->scene, dt);
-
-            return false;
+            break;
         }
         case SCENE_GAME_OVER_LOSS: {
             sdl_clear();
             asset_render(state->lose_screen);
             sdl_show();
-            return false;
+            break;
         }
         case SCENE_GAME_OVER_WIN: {
             sdl_clear();
             asset_render(state->win_screen);
             sdl_show();
-            return false;
+            break;
+        }
+    }
+}
+
+/**
+ * Checks whether a scene only shows still images, so it doesn't need to be
+ * simulated or redrawn until something changes.
+ * 
+ * @param type the type of the scene
+ * @return true for the menu and game over screens, false otherwise
+*/
+bool is_static_scene(scene_type_t type) {
+    return type == SCENE_MENU || type == SCENE_GAME_OVER_LOSS || 
+           type == SCENE_GAME_OVER_WIN;
+}
+
+/**
+ * Samples the values the telemetry records for the frame that just ended.
+ * 
+ * @param state the game state
+ * @param interval the time since the previous frame
+ * @param steps the number of simulation steps taken this frame
+ * @return the frame's telemetry record
+*/
+telemetry_record_t sample_telemetry(state_t *state, double interval, size_t steps) {
+    telemetry_record_t record = {
+        .dt = interval,
+        .steps = steps,
+        .bodies = scene_bodies(state->scene),
+        .projectiles = list_size(state->projectiles),
+        .enemies = list_size(state->enemies),
+        .force_creators = scene_force_creators(state->scene),
+        .assets = list_size(state->body_assets),
+        .player_health = player_get_health(state->player),
+        .player_exp = player_get_exp(state->player),
+        .player_level = player_get_level(state->player),
+        .boss_health = state->boss_spawned ? (int32_t)boss_get_health(state->boss) : -1,
+    };
+    for (profile_stage_t stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+        record.stages[stage] = profiler_get_last(stage);
+    }
+    return record;
+}
+
+bool emscripten_main(state_t *state) {
+    // Upload images decoded in the background, and redraw a static screen
+    // that may have been waiting on one
+    if (asset_cache_pump(ASSET_UPLOAD_BUDGET) > 0) {
+        sdl_request_redraw();
+        // The cached layers may have been drawn with placeholders
+        layer_cache_invalidate(state->background_layer);
+        layer_cache_invalidate(state->hud_layer);
+    }
+
+    // Static screens are only drawn when they first appear or when input or
+    // the window asks for it; otherwise sleep until the next event
+    scene_type_t scene_type = scene_get_type(state->scene);
+    if (is_static_scene(scene_type)) {
+        if (sdl_redraw_requested() || scene_type != state->drawn_scene) {
+            game_render(state, 1.0);
+            state->drawn_scene = scene_type;
         }
+        // Don't sleep long while images are still on their way
+        sdl_wait_event(asset_cache_get_pending() > 0 ? FIXED_DT : STATIC_WAIT_TIME);
+
+        // Don't let the time spent waiting turn into a huge first step
+        // once the game starts moving again
+        state->accumulator = 0.0;
+        reset_tick_timer();
+        log_end_frame();
+        return false;
     }
+    state->drawn_scene = scene_type;
+
+    // Simulate in fixed steps so that results don't depend on the frame rate
+    // and a slow frame can't make bullets tunnel through their targets
+    double frame_interval = time_since_last_tick();
+    state->accumulator += frame_interval;
+    FLIGHT_FRAME_BEGIN(frame_interval);
+    PROFILE_FRAME_BEGIN();
+
+    size_t steps = 0;
+    while (state->accumulator >= FIXED_DT && steps < MAX_STEPS_PER_FRAME) {
+        TRACE_BEGIN("game_update");
+        game_update(state, FIXED_DT);
+        TRACE_END("game_update");
+        state->accumulator -= FIXED_DT;
+        steps++;
+    }
+
+    // After a long hitch, drop the time we couldn't catch up on rather than
+    // spending the next frames fast-forwarding through it
+    if (state->accumulator >= FIXED_DT) {
+        state->accumulator = fmod(state->accumulator, FIXED_DT);
+    }
+
+    TRACE_BEGIN("game_render");
+    game_render(state, state->accumulator / FIXED_DT);
+    TRACE_END("game_render");
+    PROFILE_FRAME_END();
+    FLIGHT_FRAME_END(scene_bodies(state->scene), scene_force_creators(state->scene),
+                     list_size(state->projectiles), list_size(state->enemies));
+    TELEMETRY_RECORD(sample_telemetry(state, frame_interval, steps));
+
+    TRACE_COUNTER("bodies", scene_bodies(state->scene));
+    TRACE_COUNTER("force_creators", scene_force_creators(state->scene));
+    TRACE_COUNTER("projectiles", list_size(state->projectiles));
+    log_end_frame();
+    return false;
 }
 
 void emscripten_free(state_t *state) {
-    asset_cache_destroy();
+    TRACE_FINISH();
+    TELEMETRY_FINISH();
     list_free(state->body_assets);
     scene_free(state->scene);
     player_free(state->player); 
     boss_free(state->boss);
     portal_free(state->portal);
 
-    list_free_with_function(state->projectiles, (free_func_t)projectile_free);
-    list_free_with_function(state->enemies, (free_func_t)enemy_free); 
-
-    clear_screen(state);
-    clear_enemies(state);
-    clear_projectiles(state);
+    // Both lists free their items with their own free functions
+    list_free(state->projectiles);
+    list_free(state->enemies);
 
+    // Only the current scene's images are left, the rest are NULL, and the
+    // buttons belong to the asset cache
     asset_destroy(state->start_screen);
     asset_destroy(state->lose_screen);
     asset_destroy(state->win_screen);
-    asset_destroy(state->play_button);
-    asset_destroy(state->restart_button);
     asset_destroy(state->overworld_image);
     asset_destroy(state->boss_background_image);
+    asset_destroy(state->interface_image);
+    list_free(state->button_images);
+    asset_cache_destroy();
+    layer_cache_free(state->background_layer);
+    layer_cache_free(state->hud_layer);
+    hud_text_free(state->health_text);
+    hud_text_free(state->exp_text);
+    hud_text_free(state->bullets_text);
 
     free(state);
 
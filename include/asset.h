@@ -62,6 +62,17 @@ asset_t *asset_make_image_with_body_angle(const char *filepath, SDL_Rect boundin
 */
 body_t *asset_get_body(asset_t *asset);
 
+/**
+ * Sets the layer an image asset is drawn in (see render_layer_t). Images
+ * start out in LAYER_WORLD.
+ *
+ * Asserts that `image_asset` has type `ASSET_IMAGE`.
+ *
+ * @param image_asset the image asset
+ * @param layer the layer to draw it in
+ */
+void asset_set_layer(asset_t *image_asset, render_layer_t layer);
+
 /**
  * Allocates memory for a text asset with the given parameters.
  *
@@ -119,7 +130,17 @@ void asset_on_button_click(asset_t *button, state_t *state, double x, double y);
 void asset_render(asset_t *asset);
 
 /**
- * Frees the memory allocated for the asset.
+ * Renders the asset to the screen. Images attached to a body are drawn at the
+ * body's position interpolated between its last two simulation steps.
+ *
+ * @param asset the asset to render
+ * @param alpha how far to blend, from 0 (previous position) to 1 (current)
+ */
+void asset_render_interpolated(asset_t *asset, double alpha);
+
+/**
+ * Frees the memory allocated for the asset and releases its image or font in
+ * the asset cache. Does nothing if `asset` is NULL.
  * @param asset the asset to free
  */
 void asset_destroy(asset_t *asset);
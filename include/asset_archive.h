@@ -0,0 +1,104 @@
+#ifndef __ASSET_ARCHIVE_H__
+#define __ASSET_ARCHIVE_H__
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A single file holding every asset, so the game opens one file instead of
+ * twenty and emscripten preloads one blob. tools/asset_pack.c writes it
+ * (run 'make assets.pack').
+ *
+ * The file is a header, then an index of every asset sorted by the hash of
+ * its path, then the paths, then the assets themselves, each starting on a
+ * ASSET_ARCHIVE_ALIGNMENT boundary. The archive is mapped into memory
+ * rather than read, and assets are handed to SDL as read-only views into
+ * the mapping, so nothing is copied before the decoder sees it.
+ *
+ * Assets are looked up by the same paths the game passes to the asset
+ * cache, e.g. "assets/wizzy.png". Paths that aren't in the archive, or every
+ * path if there is no archive, are opened from disk as before.
+ */
+#define ASSET_ARCHIVE_MAGIC "RMDPACK\0"
+#define ASSET_ARCHIVE_VERSION 1
+#define ASSET_ARCHIVE_ALIGNMENT 16
+
+/**
+ * The start of an archive, followed by `count` index entries.
+ */
+typedef struct asset_archive_header {
+  char magic[8]; // ASSET_ARCHIVE_MAGIC
+  uint32_t version;
+  uint32_t count;
+} asset_archive_header_t;
+
+/**
+ * Where one asset is in the archive. Offsets are from the start of the file,
+ * and the path isn't null-terminated.
+ */
+typedef struct asset_archive_entry {
+  uint64_t hash; // asset_archive_hash() of the path
+  uint64_t offset;
+  uint64_t size;
+  uint32_t path_offset;
+  uint32_t path_size;
+} asset_archive_entry_t;
+
+/**
+ * Hashes an asset's path for the archive index (64-bit FNV-1a).
+ * Shared by the packer and the reader, so it lives in the header.
+ *
+ * @param path the path, e.g. "assets/wizzy.png"
+ * @return the hash
+ */
+static inline uint64_t asset_archive_hash(const char *path) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (; *path != '\0'; path++) {
+    hash ^= (unsigned char)*path;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/**
+ * Maps an archive into memory and checks its header and index.
+ * Replaces any archive that was already open. The archive is unmapped at
+ * exit, since the music keeps reading from it until then.
+ *
+ * @param path the path to the archive
+ * @return true if the archive was opened; if not, every asset is read from
+ * its own file
+ */
+bool asset_archive_open(const char *path);
+
+/**
+ * Unmaps the archive. Any view returned by asset_archive_find() or
+ * asset_archive_rw() is invalid afterwards.
+ */
+void asset_archive_close(void);
+
+/**
+ * Finds an asset in the archive.
+ * Safe to call from any thread while the archive is open.
+ *
+ * @param path the asset's path
+ * @param size set to the asset's size in bytes if it is found
+ * @return a read-only pointer to the asset's bytes, or NULL if there is no
+ * archive or it doesn't hold the asset
+ */
+const void *asset_archive_find(const char *path, size_t *size);
+
+/**
+ * Opens an asset for SDL: a view into the archive if it holds the asset,
+ * otherwise the file itself.
+ * Safe to call from any thread while the archive is open.
+ *
+ * @param path the asset's path
+ * @return the stream, which the caller must close (e.g. by passing it to an
+ * SDL *_RW loader with freesrc set), or NULL if the asset can't be found
+ */
+SDL_RWops *asset_archive_rw(const char *path);
+
+#endif // #ifndef __ASSET_ARCHIVE_H__
@@ -5,27 +5,47 @@
 #include <stddef.h>
 
 /**
- * Initializes the empty, list-based global asset cache. The caller must then
- * destroy the cache with `asset_cache_destroy` when done.
+ * Initializes the empty global asset cache. The caller must then destroy the
+ * cache with `asset_cache_destroy` when done.
+ *
+ * Images and fonts are kept in separate hash tables keyed by their path.
+ * Paths are interned, and the most recent path pointers passed in are
+ * remembered in a small fixed-size cache, so looking up a string literal that
+ * was seen recently takes two pointer hashes and no string comparisons. A remembered pointer is trusted without reading it, so
+ * every path passed to the cache must be a string that outlives the cache and
+ * never changes, such as a string literal; a reused buffer may find the
+ * asset its previous contents named.
+ *
+ * Also opens assets.pack, if there is one, so images and fonts are read out
+ * of it (see asset_archive.h).
  */
 void asset_cache_init();
 
 /**
- * Frees the global asset cache and its owned contents.
+ * Frees the global asset cache and its owned contents, including every
+ * registered button.
  */
 void asset_cache_destroy();
 
 /**
- * Gets the pointer to the object that is associated with the given filepath.
- * If the object exists, asserts that its type matches the given type.
+ * Gets the pointer to the object that is associated with the given filepath
+ * and type, which must be ASSET_IMAGE or ASSET_FONT.
  *
  * If the object doesn't exist, adds a new entry to the asset cache and returns
- * the pointer to the newly created object.
+ * the pointer to the newly created object. The object stays valid until
+ * asset_cache_purge() or asset_cache_destroy(); use asset_cache_acquire() to
+ * keep it loaded for longer.
+ *
+ * Images are returned as sprites: small images are packed into a shared
+ * atlas texture (see atlas.h), so the sprite's source rect must be drawn
+ * rather than the whole texture. An image's sprite pointer never changes
+ * while the cache exists. When the image is freed its texture becomes NULL,
+ * and a prefetched image's sprite is filled in once it is uploaded.
  *
  * Example:
  * ```
  * char *img_path = "assets/image.png";
- * SDL_Texture *obj = asset_cache_obj_get_or_create(ASSET_IMAGE, img_path);
+ * sprite_t *obj = asset_cache_obj_get_or_create(ASSET_IMAGE, img_path);
  *
  * char *font_path = "assets/font.ttf";
  * TTF_Font *obj = asset_cache_obj_get_or_create(ASSET_FONT, font_path);
@@ -37,6 +57,102 @@ void asset_cache_destroy();
  */
 void *asset_cache_obj_get_or_create(asset_type_t ty, const char *filepath);
 
+/**
+ * Gets an object like asset_cache_obj_get_or_create() and takes a reference
+ * to it. Objects with references are never purged. Every call must be paired
+ * with a call to asset_cache_release(); assets do this for their images and
+ * fonts.
+ *
+ * @param ty the type of the asset
+ * @param filepath the filepath to the asset
+ * @return the object that corresponds to the filepath, as a void*
+ */
+void *asset_cache_acquire(asset_type_t ty, const char *filepath);
+
+/**
+ * Gives back a reference taken by asset_cache_acquire(). The object stays
+ * loaded once nothing references it, so it can be reused right away, until
+ * asset_cache_purge() frees it. Does nothing after asset_cache_destroy().
+ *
+ * @param ty the type of the asset
+ * @param filepath the filepath to the asset
+ */
+void asset_cache_release(asset_type_t ty, const char *filepath);
+
+/**
+ * Starts decoding an image on a background thread, so it is ready by the
+ * time it is needed without stalling a frame. Until asset_cache_pump()
+ * uploads it, the image's sprite shows a transparent placeholder texture
+ * (see asset_cache_is_placeholder()). Does nothing if the image is already
+ * loaded or on its way.
+ *
+ * Under emscripten there are no decoder threads, so the image is decoded by
+ * asset_cache_pump() instead, still spread out over frames.
+ *
+ * @param filepath the filepath to the image
+ */
+void asset_cache_prefetch(const char *filepath);
+
+/**
+ * Uploads decoded images to textures. Must be called from the main thread,
+ * once per frame. Keeps uploading until no more images are ready or
+ * `time_budget` has passed, but always uploads at least one ready image.
+ *
+ * @param time_budget how long to spend uploading, in seconds
+ * @return the number of images uploaded
+ */
+size_t asset_cache_pump(double time_budget);
+
+/**
+ * Gets the number of prefetched images that haven't been uploaded yet.
+ *
+ * @return the number of images
+ */
+size_t asset_cache_get_pending();
+
+/**
+ * Checks whether an image from the cache is still showing the placeholder
+ * because it hasn't been uploaded yet.
+ *
+ * @param sprite an image's sprite returned by the cache
+ * @return true if `sprite` draws the placeholder
+ */
+bool asset_cache_is_placeholder(const sprite_t *sprite);
+
+/**
+ * Limits how much memory loaded textures may take. Whenever they take more,
+ * the least recently used images that nothing holds a reference to are freed
+ * until they fit again; referenced images are never freed, so the budget can
+ * still be exceeded by them. Freed images are loaded again the next time they
+ * are requested.
+ *
+ * The budget starts out unlimited, or at ASSET_CACHE_BUDGET_MB megabytes if
+ * that environment variable is set when the cache is initialized.
+ *
+ * Note that an object returned by asset_cache_obj_get_or_create() can be
+ * freed by a later request once a budget is set; call it again rather than
+ * keeping the pointer. Atlased images count as their share of the atlas pages
+ * and are never evicted.
+ *
+ * @param bytes the most memory textures should take, approximately
+ */
+void asset_cache_set_budget(size_t bytes);
+
+/**
+ * Gets the approximate memory taken by every loaded texture, from their
+ * dimensions and pixel formats.
+ *
+ * @return the number of bytes
+ */
+size_t asset_cache_get_texture_bytes();
+
+/**
+ * Frees every image and font that nothing holds a reference to, e.g. a
+ * background whose scene is over. They are loaded again if they are
+ * requested later. Images in the atlas stay loaded.
+ */
+void asset_cache_purge();
+
 /**
  * Registers the button to the asset cache, effectively activating its button
  * handler. When this function is called, the asset_cache takes ownership of the
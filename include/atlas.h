@@ -0,0 +1,45 @@
+#ifndef __ATLAS_H__
+#define __ATLAS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "sdl_wrapper.h"
+
+/**
+ * Packs small images into a few large textures ("pages"), so sprites drawn
+ * together share a texture and can be batched instead of each needing its
+ * own texture bind.
+ *
+ * Images are packed as they are loaded, onto shelves: rows as tall as the
+ * first image placed on them, filled left to right. A page that can't fit an
+ * image gets a new page after it. Space is never reclaimed, so atlased
+ * images stay loaded until atlas_clear(); only images up to
+ * ATLAS_MAX_SPRITE_SIZE on each side are taken, which keeps that cheap.
+ */
+#define ATLAS_PAGE_SIZE 1024
+#define ATLAS_MAX_SPRITE_SIZE 256
+
+/**
+ * Copies an image into the atlas. Must be called from the main thread.
+ *
+ * @param surface the image; still belongs to the caller
+ * @param sprite set to the page and the part of it holding the image
+ * @return false if the image is too big for the atlas, or there is no
+ * renderer to make pages with, in which case `sprite` is unchanged
+ */
+bool atlas_add(SDL_Surface *surface, sprite_t *sprite);
+
+/**
+ * Destroys every page. Sprites from the atlas are invalid afterwards.
+ */
+void atlas_clear(void);
+
+/**
+ * Gets the memory taken by the pages.
+ *
+ * @return the number of bytes
+ */
+size_t atlas_get_bytes(void);
+
+#endif // #ifndef __ATLAS_H__
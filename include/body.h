@@ -18,7 +18,7 @@ typedef struct body body_t;
  * Acts like body_init_with_info() where info and info_freer are NULL.
  */
 
-body_t *body_init(list_t *shape, double mass, rgb_color_t color);
+body_t *body_init(list_t *shape, scalar_t mass, rgb_color_t color);
 
 /**
  * Allocates memory for a body with the given parameters.
@@ -33,7 +33,7 @@ body_t *body_init(list_t *shape, double mass, rgb_color_t color);
  * @param info_freer if non-NULL, a function call on the info to free it
  * @return a pointer to the newly allocated body
  */
-body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
+body_t *body_init_with_info(list_t *shape, scalar_t mass, rgb_color_t color,
                             void *info, free_func_t info_freer);
 
 /**
@@ -72,6 +72,17 @@ list_t *body_get_shape(body_t *body);
  */
 vector_t body_get_centroid(body_t *body);
 
+/**
+ * Gets the center of mass of a body blended between where it was before the
+ * last body_tick() and where it is now. Used to render smoothly between
+ * fixed-size simulation steps.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param alpha how far to blend, from 0 (previous position) to 1 (current)
+ * @return the interpolated center of mass
+ */
+vector_t body_get_interpolated_centroid(body_t *body, double alpha);
+
 /**
  * Gets the current velocity of a body.
  *
@@ -94,7 +105,7 @@ rgb_color_t *body_get_color(body_t *body);
  * @param body a pointer to a body returned from body_init()
  * @return the body's rotation angle in radians
  */
-double body_get_rotation(body_t *body);
+scalar_t body_get_rotation(body_t *body);
 
 /**
  * Gets the mass of a body.
@@ -102,7 +113,7 @@ double body_get_rotation(body_t *body);
  * @param body a pointer to a body returned from body_init()
  * @return the body's mass
  */
-double body_get_mass(body_t *body);
+scalar_t body_get_mass(body_t *body);
 
 /**
  * Gets the polygon object associated with the body
@@ -152,7 +163,7 @@ void body_set_velocity(body_t *body, vector_t v);
  * @param body a pointer to a body returned from body_init()
  * @param angle the body's new angle in radians. Positive is counterclockwise.
  */
-void body_set_rotation(body_t *body, double angle);
+void body_set_rotation(body_t *body, scalar_t angle);
 
 /**
  * Updates the body after a given time interval has elapsed.
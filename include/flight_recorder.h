@@ -0,0 +1,67 @@
+#ifndef __FLIGHT_RECORDER_H__
+#define __FLIGHT_RECORDER_H__
+
+#include <stddef.h>
+
+/**
+ * Keeps the last few hundred frames' stage timings, entity counts and input
+ * events in a ring buffer. When a frame takes longer than the budget, the
+ * whole buffer is written to flight_<n>.json, so a one-off spike comes with
+ * the frames that led up to it.
+ *
+ * The FLIGHT_* macros compile to nothing unless the game is built with
+ * -DFLIGHT_RECORDER (run 'make FLIGHT_RECORDER=true'). Stage timings come
+ * from the PROFILE_* stages in profiler.h, which are enabled along with it.
+ */
+#ifdef FLIGHT_RECORDER
+#define FLIGHT_FRAME_BEGIN(interval) flight_recorder_frame_begin(interval)
+#define FLIGHT_FRAME_END(bodies, force_creators, projectiles, enemies)         \
+  flight_recorder_frame_end(bodies, force_creators, projectiles, enemies)
+#define FLIGHT_INPUT(type, code, x, y) flight_recorder_input(type, code, x, y)
+#else
+#define FLIGHT_FRAME_BEGIN(interval) ((void)0)
+#define FLIGHT_FRAME_END(bodies, force_creators, projectiles, enemies)         \
+  ((void)0)
+#define FLIGHT_INPUT(type, code, x, y) ((void)0)
+#endif
+
+/**
+ * Sets how long a frame may take before the recorder is dumped.
+ * Defaults to 25 ms, or to the FLIGHT_BUDGET_MS environment variable if set.
+ *
+ * @param seconds the frame budget in seconds
+ */
+void flight_recorder_set_budget(double seconds);
+
+/**
+ * Starts recording a frame.
+ *
+ * @param interval the time since the previous frame started, in seconds;
+ * this is what is compared against the budget
+ */
+void flight_recorder_frame_begin(double interval);
+
+/**
+ * Finishes the current frame, reading its stage timings from the profiler,
+ * and dumps the recorder if the frame went over budget.
+ *
+ * @param bodies the number of bodies in the scene
+ * @param force_creators the number of force creators in the scene
+ * @param projectiles the number of projectiles in flight
+ * @param enemies the number of enemies alive
+ */
+void flight_recorder_frame_end(size_t bodies, size_t force_creators,
+                               size_t projectiles, size_t enemies);
+
+/**
+ * Records an input event. Events are attached to the next frame to finish,
+ * which is the first frame they can affect.
+ *
+ * @param type a string literal naming the event, e.g. "key_down"
+ * @param code the key or button involved
+ * @param x the x position of the mouse, or 0 for key events
+ * @param y the y position of the mouse, or 0 for key events
+ */
+void flight_recorder_input(const char *type, int code, double x, double y);
+
+#endif // #ifndef __FLIGHT_RECORDER_H__
@@ -27,7 +27,7 @@ force_activator_t *force_act_init(force_creator_t forcer, void *aux,
  * @param force_const the force constant passed to create_collision()
  */
 typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
-                                    void *aux, double force_const);
+                                    void *aux, scalar_t force_const);
 
 /**
  * Adds a force creator to a scene that applies gravity between two bodies.
@@ -43,7 +43,7 @@ typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
  * @param body1 the first body
  * @param body2 the second body
  */
-void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
+void create_newtonian_gravity(scene_t *scene, scalar_t G, body_t *body1,
                               body_t *body2);
 
 /**
@@ -57,7 +57,7 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
  * @param body1 the first body
  * @param body2 the second body
  */
-void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
+void create_spring(scene_t *scene, scalar_t k, body_t *body1, body_t *body2);
 
 /**
  * Adds a force creator to a scene that applies a drag force on a body.
@@ -70,7 +70,7 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
  *   (higher gamma means more drag)
  * @param body the body to slow down
  */
-void create_drag(scene_t *scene, double gamma, body_t *body);
+void create_drag(scene_t *scene, scalar_t gamma, body_t *body);
 
 /**
  * Adds a force creator to a scene that calls a given collision handler
@@ -89,7 +89,7 @@ void create_drag(scene_t *scene, double gamma, body_t *body);
  */
 void create_collision(scene_t *scene, body_t *body1, body_t *body2,
                       collision_handler_t handler, void *aux,
-                      double force_const);
+                      scalar_t force_const);
 
 /**
  * Adds a force creator to a scene that destroys two bodies when they collide.
@@ -108,7 +108,7 @@ void create_destructive_collision(scene_t *scene, body_t *body1, body_t *body2);
  * bodies according to the elasticity in `aux`.
  */
 void physics_collision_handler(body_t *body1, body_t *body2, vector_t axis,
-                               void *aux, double force_const);
+                               void *aux, scalar_t force_const);
 
 /**
  * Adds a force creator to a scene that applies impulses
@@ -128,6 +128,6 @@ void physics_collision_handler(body_t *body1, body_t *body2, vector_t axis,
  * 0 is a perfectly inelastic collision and 1 is a perfectly elastic collision
  */
 void create_physics_collision(scene_t *scene, body_t *body1, body_t *body2,
-                              double elasticity);
+                              scalar_t elasticity);
 
 #endif // #ifndef __FORCES_H__
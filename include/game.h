@@ -0,0 +1,88 @@
+#ifndef __GAME_H__
+#define __GAME_H__
+
+#include "player.h"
+#include "scene.h"
+#include "state.h"
+
+/**
+ * Entry points into game/game.c beyond the emscripten_* functions in state.h,
+ * so the game can be driven without the usual main loop (e.g. by the
+ * benchmarks in bench/).
+ */
+
+/**
+ * The length of one simulation step in seconds.
+ */
+extern const double FIXED_DT;
+
+/**
+ * Advances the game by one simulation step.
+ *
+ * @param state the current state of the game
+ * @param dt the length of the step in seconds (normally FIXED_DT)
+ */
+void game_update(state_t *state, double dt);
+
+/**
+ * Draws the current frame.
+ *
+ * @param state the current state of the game
+ * @param alpha how far between the last two simulation steps to draw bodies,
+ * from 0 (previous step) to 1 (latest step)
+ */
+void game_render(state_t *state, double alpha);
+
+/**
+ * Leaves the menu and starts the game, as if the play button was clicked.
+ *
+ * @param state the current state of the game
+ */
+void play(state_t *state);
+
+/**
+ * Gets the player of the game.
+ *
+ * @param state the current state of the game
+ * @return the player
+ */
+player_t *game_get_player(state_t *state);
+
+/**
+ * Gets the scene holding every body in the game.
+ *
+ * @param state the current state of the game
+ * @return the scene
+ */
+scene_t *game_get_scene(state_t *state);
+
+/**
+ * Spawns an enemy at a random location on the border of the map.
+ *
+ * @param state the current state of the game
+ * @param damage the damage dealt by the enemy's attacks
+ */
+void spawn_enemy(state_t *state, size_t damage);
+
+/**
+ * Spawns the boss at the center of the screen.
+ *
+ * @param state the current state of the game
+ */
+void spawn_boss(state_t *state);
+
+/**
+ * Fires the boss's ring attack. The boss must have been spawned.
+ *
+ * @param state the current state of the game
+ */
+void render_boss_ring_attack(state_t *state);
+
+/**
+ * Fires the boss's ray attack at the player. The boss must have been spawned.
+ *
+ * @param state the current state of the game
+ */
+void render_boss_ray_attack(state_t *state);
+
+#endif // #ifndef __GAME_H__
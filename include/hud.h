@@ -0,0 +1,55 @@
+#ifndef __HUD_H__
+#define __HUD_H__
+
+#include "sdl_wrapper.h"
+
+/**
+ * The longest text a HUD text widget shows, including the terminator.
+ * Longer text is cut off.
+ */
+#define HUD_TEXT_SIZE 64
+
+/**
+ * A line of text on the HUD, such as a bar's label. The widget keeps its
+ * text rasterized in a texture and only renders it again when the text
+ * changes, so a value that is set every frame but rarely changes costs a
+ * string comparison instead of a font render and a texture upload.
+ */
+typedef struct hud_text hud_text_t;
+
+/**
+ * Allocates an empty text widget. Must be freed with hud_text_free().
+ *
+ * @param font the font to render the text with; still belongs to the caller
+ * @param position where to draw the text; its width and height are replaced
+ * by the text's own size, like sdl_render_text_color()
+ * @param color the color of the text
+ * @return the new widget
+ */
+hud_text_t *hud_text_init(TTF_Font *font, SDL_Rect position, SDL_Color color);
+
+/**
+ * Sets a widget's text with printf-style formatting. The text is only
+ * rasterized again if it is different from before.
+ *
+ * @param text the widget
+ * @param format the format string, followed by its arguments
+ */
+void hud_text_set(hud_text_t *text, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * Draws a widget's text.
+ *
+ * @param text the widget
+ */
+void hud_text_render(hud_text_t *text);
+
+/**
+ * Frees a text widget and its texture. Does nothing if `text` is NULL.
+ *
+ * @param text the widget
+ */
+void hud_text_free(hud_text_t *text);
+
+#endif // #ifndef __HUD_H__
@@ -0,0 +1,77 @@
+#ifndef __LAYER_CACHE_H__
+#define __LAYER_CACHE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A layer of the screen that is drawn once into a texture and then reused,
+ * so a frame draws the layer with a single blit. It is only drawn again when
+ * its key changes: the values its contents are drawn from, such as which
+ * background is showing or the player's health.
+ *
+ * Usage, at the point in the frame where the layer belongs:
+ * ```
+ * if (layer_cache_begin(cache, &key, sizeof(key))) {
+ *   // draw the layer's contents
+ *   layer_cache_end(cache);
+ * }
+ * layer_cache_draw(cache);
+ * ```
+ *
+ * If the renderer can't draw into textures, the contents are drawn directly
+ * every frame instead, and layer_cache_draw() does nothing.
+ */
+typedef struct layer_cache layer_cache_t;
+
+/**
+ * Allocates an empty layer cache. Must be freed with layer_cache_free().
+ *
+ * @return the new cache
+ */
+layer_cache_t *layer_cache_init(void);
+
+/**
+ * Checks whether the layer must be drawn again, because its key changed,
+ * it was invalidated, or its texture lost its contents. If so, starts
+ * sending drawing into the layer's texture, which the caller must end with
+ * layer_cache_end() once the contents are drawn.
+ *
+ * @param cache the layer cache
+ * @param key the values the contents are drawn from; compared bytewise, so
+ * structs should be zeroed before being filled in
+ * @param key_size the size of `key` in bytes
+ * @return true if the caller must draw the contents now
+ */
+bool layer_cache_begin(layer_cache_t *cache, const void *key, size_t key_size);
+
+/**
+ * Goes back to drawing to the window after layer_cache_begin().
+ *
+ * @param cache the layer cache
+ */
+void layer_cache_end(layer_cache_t *cache);
+
+/**
+ * Draws the layer's texture over the whole window.
+ *
+ * @param cache the layer cache
+ */
+void layer_cache_draw(layer_cache_t *cache);
+
+/**
+ * Makes the next layer_cache_begin() draw the layer again even if its key is
+ * unchanged, e.g. because an image in it finished loading.
+ *
+ * @param cache the layer cache
+ */
+void layer_cache_invalidate(layer_cache_t *cache);
+
+/**
+ * Frees a layer cache and its texture. Does nothing if `cache` is NULL.
+ *
+ * @param cache the layer cache
+ */
+void layer_cache_free(layer_cache_t *cache);
+
+#endif // #ifndef __LAYER_CACHE_H__
@@ -0,0 +1,90 @@
+#ifndef __LOG_H__
+#define __LOG_H__
+
+/**
+ * A leveled logger that keeps printing off the game's hot paths.
+ *
+ * A log call formats its message straight into a slot of a fixed ring buffer
+ * and returns; it never blocks, allocates or does I/O. A background thread
+ * prints the queued messages. Under emscripten, where stdout goes through the
+ * slow JS console and there is no thread, they are printed by log_end_frame()
+ * at the end of each frame instead. Anything still queued is printed at exit.
+ *
+ * The ring has a single producer, so messages may only be logged from the
+ * game's thread. Messages longer than LOG_MESSAGE_SIZE are cut short, and
+ * messages logged while the ring is full are dropped and counted.
+ *
+ * Log calls below LOG_LEVEL are compiled out, arguments and all. It defaults
+ * to LOG_LEVEL_INFO; build with e.g. 'make LOG_LEVEL=WARN' to change it.
+ *
+ * Example:
+ * ```
+ * LOG_INFO("You have leveled up! You are now level %zu.", level);
+ * ```
+ */
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) log_write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) log_write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) log_write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) log_write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#define LOG_MESSAGE_SIZE 120
+
+/**
+ * Starts the thread that prints queued messages and arranges for the rest of
+ * the queue to be printed at exit. Messages logged before this are kept.
+ * Calling it again does nothing.
+ */
+void log_init(void);
+
+/**
+ * Queues a message. Normally called through the LOG_* macros.
+ * A newline is added when the message is printed.
+ *
+ * @param level one of the LOG_LEVEL_* values
+ * @param format a printf-style format string
+ */
+void log_write(int level, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * Prints every queued message if there is no background thread to do it,
+ * e.g. under emscripten. Call once per frame, after the frame is drawn.
+ */
+void log_end_frame(void);
+
+/**
+ * Stops the background thread and prints every message still queued.
+ * log_init() registers this to run at exit.
+ */
+void log_shutdown(void);
+
+#endif // #ifndef __LOG_H__
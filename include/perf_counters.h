@@ -0,0 +1,68 @@
+#ifndef __PERF_COUNTERS_H__
+#define __PERF_COUNTERS_H__
+
+#include <stdio.h>
+
+#include "profiler.h"
+
+/**
+ * Counts hardware events (cycles, instructions, L1 data cache misses, last
+ * level cache misses and branch misses) in every stage timed with
+ * PROFILE_BEGIN and PROFILE_END, using Linux's perf_event_open.
+ * This shows what wall time can't, e.g. whether a change to the body layout
+ * actually cut cache misses per tick.
+ *
+ * The counters only count this thread in user space. Reading them is a system
+ * call at the start and end of every stage, so timings in this build are a
+ * little slower than in a normal one.
+ *
+ * If the counters can't be opened (not on Linux, under emscripten, or when
+ * /proc/sys/kernel/perf_event_paranoid forbids it), each stage still gets its
+ * call count and wall time, and the report says why the counters are missing.
+ * Counters the CPU doesn't support are left out one by one.
+ *
+ * The report is printed to stderr when the program exits.
+ *
+ * PERF_INIT compiles to nothing unless the game is built with
+ * -DPERF_COUNTERS (run 'make PERF_COUNTERS=true').
+ */
+#ifdef PERF_COUNTERS
+#define PERF_INIT() perf_counters_init()
+#else
+#define PERF_INIT() ((void)0)
+#endif
+
+/**
+ * Opens the counters, clears every stage's totals and arranges for
+ * perf_counters_report() to run at exit. Calling it again clears the totals
+ * and keeps the counters open.
+ */
+void perf_counters_init(void);
+
+/**
+ * Reads the counters at the start of a stage.
+ * Called by profiler_stage_begin().
+ *
+ * @param stage the stage that is starting
+ */
+void perf_counters_stage_begin(profile_stage_t stage);
+
+/**
+ * Reads the counters at the end of a stage and adds the difference to its
+ * totals. Called by profiler_stage_end().
+ *
+ * @param stage the stage that finished
+ * @param seconds the wall time the stage took
+ */
+void perf_counters_stage_end(profile_stage_t stage, double seconds);
+
+/**
+ * Prints a table with one row per stage that ran: the number of calls, wall
+ * time and each counter's total, plus instructions per cycle and misses per
+ * thousand instructions. The counters stay open.
+ *
+ * @param out where to print the report
+ */
+void perf_counters_report(FILE *out);
+
+#endif // #ifndef __PERF_COUNTERS_H__
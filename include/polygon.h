@@ -23,7 +23,7 @@ typedef struct polygon polygon_t;
  * @return a polygon object pointer
  */
 polygon_t *polygon_init(list_t *points, vector_t initial_velocity,
-                        double rotation_speed, double red, double green,
+                        scalar_t rotation_speed, double red, double green,
                         double blue);
 
 /**
@@ -51,7 +51,7 @@ void polygon_move(polygon_t *polygon, double time_elapsed);
  * each pair of consecutive vertices, plus one between the first and last.
  * @return the area of the polygon
  */
-double polygon_area(polygon_t *polygon);
+scalar_t polygon_area(polygon_t *polygon);
 
 /**
  * Computes the center of mass of a polygon.
@@ -82,7 +82,7 @@ void polygon_translate(polygon_t *polygon, vector_t translation);
  * A positive angle means counterclockwise.
  * @param point the point to rotate around
  */
-void polygon_rotate(polygon_t *polygon, double angle, vector_t point);
+void polygon_rotate(polygon_t *polygon, scalar_t angle, vector_t point);
 
 /**
  * Return the polygon's color.
@@ -120,17 +120,17 @@ vector_t polygon_get_center(polygon_t *polygon);
  * Sets the rotation angle of the polygon relative to the vertical.
  *
  * @param polygon a polygon_t struct
- * @param rot a double value of the angle in radians
+ * @param rot the angle in radians
  */
-void polygon_set_rotation(polygon_t *polygon, double rot);
+void polygon_set_rotation(polygon_t *polygon, scalar_t rot);
 
 /**
  * Returns the rotation angle of the polygon relative to the vertical.
  *
  * @param polygon a polygon_t struct
- * @return a double value of the angle in radians
+ * @return the angle in radians
  */
-double polygon_get_rotation(polygon_t *polygon);
+scalar_t polygon_get_rotation(polygon_t *polygon);
 
 /**
  * Set the x and y components of a polygon's velocity vector.
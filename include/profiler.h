@@ -0,0 +1,130 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include "timer.h"
+
+/**
+ * The stages of a frame that the profiler times.
+ * A stage may run several times per frame (e.g. once per simulation step);
+ * its times are added up over the frame.
+ */
+typedef enum {
+  PROFILE_SCENE_FORCES,
+  PROFILE_SCENE_TICK,
+  PROFILE_CLEAR_ENEMIES,
+  PROFILE_RENDER_ASSETS,
+  PROFILE_RENDER_BARS,
+  PROFILE_SDL_SHOW,
+  PROFILE_STAGE_COUNT
+} profile_stage_t;
+
+/**
+ * Timing macros. They compile to nothing unless the game is built with
+ * -DPROFILE (run 'make PROFILE=true'), so they can stay in hot code.
+ * With -DTRACE, PROFILE_BEGIN and PROFILE_END also record each stage as a
+ * span in the trace (see trace.h), and with -DPERF_COUNTERS they also count
+ * hardware events in each stage (see perf_counters.h). -DFLIGHT_RECORDER and
+ * -DTELEMETRY also turn on the stage and frame timing, which they read, but
+ * not the overlay. This header doesn't depend on SDL, so the library code and
+ * tools that only time stages or read the results can include it; the
+ * overlay that draws the results is in profiler_overlay.h.
+ *
+ * Example:
+ * ```
+ * void scene_tick(scene_t *scene, double dt) {
+ *   PROFILE_BEGIN(PROFILE_SCENE_TICK);
+ *   ...
+ *   PROFILE_END(PROFILE_SCENE_TICK);
+ * }
+ * ```
+ *
+ * PROFILE_BEGIN declares a local variable, so each stage can only be begun
+ * once per block, and PROFILE_END must be in the same block.
+ */
+#if defined(PROFILE) || defined(TRACE) || defined(FLIGHT_RECORDER) ||        \
+    defined(PERF_COUNTERS) || defined(TELEMETRY)
+#define PROFILE_BEGIN(stage)                                                   \
+  double profile_start_##stage = profiler_stage_begin(stage)
+#define PROFILE_END(stage) profiler_stage_end(stage, profile_start_##stage)
+#else
+#define PROFILE_BEGIN(stage) ((void)0)
+#define PROFILE_END(stage) ((void)0)
+#endif
+
+#if defined(PROFILE) || defined(FLIGHT_RECORDER) || defined(TELEMETRY)
+#define PROFILE_FRAME_BEGIN() profiler_frame_begin()
+#define PROFILE_FRAME_END() profiler_frame_end()
+#else
+#define PROFILE_FRAME_BEGIN() ((void)0)
+#define PROFILE_FRAME_END() ((void)0)
+#endif
+
+/**
+ * Starts timing a stage. Normally called through PROFILE_BEGIN.
+ *
+ * @param stage the stage that is starting
+ * @return the current time, to pass to profiler_stage_end()
+ */
+double profiler_stage_begin(profile_stage_t stage);
+
+/**
+ * Finishes timing a stage and adds its time to the current frame.
+ * Normally called through PROFILE_END.
+ *
+ * @param stage the stage that finished
+ * @param start the value profiler_stage_begin() returned
+ */
+void profiler_stage_end(profile_stage_t stage, double start);
+
+/**
+ * Adds time spent in a stage to the current frame.
+ *
+ * @param stage the stage that ran
+ * @param seconds how long it took
+ */
+void profiler_record(profile_stage_t stage, double seconds);
+
+/**
+ * Starts a new frame, clearing the stage times of the previous one.
+ */
+void profiler_frame_begin(void);
+
+/**
+ * Finishes the current frame and adds it to the rolling history.
+ */
+void profiler_frame_end(void);
+
+/**
+ * Gets the name of a stage, e.g. "scene_forces".
+ *
+ * @param stage a stage
+ * @return the name of the stage
+ */
+const char *profiler_stage_name(profile_stage_t stage);
+
+/**
+ * Gets the time a stage took in the last finished frame.
+ *
+ * @param stage a stage
+ * @return the time in seconds
+ */
+double profiler_get_last(profile_stage_t stage);
+
+/**
+ * Gets the average time a stage took over the recent frames
+ * (at most the last 120).
+ *
+ * @param stage a stage
+ * @return the time in seconds, or 0 if no frame has finished
+ */
+double profiler_get_average(profile_stage_t stage);
+
+/**
+ * Gets the average length of the recent frames, from profiler_frame_begin()
+ * to profiler_frame_end().
+ *
+ * @return the time in seconds, or 0 if no frame has finished
+ */
+double profiler_get_average_frame(void);
+
+#endif // #ifndef __PROFILER_H__
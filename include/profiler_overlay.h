@@ -0,0 +1,27 @@
+#ifndef __PROFILER_OVERLAY_H__
+#define __PROFILER_OVERLAY_H__
+
+#include "profiler.h"
+#include <SDL2/SDL_ttf.h>
+
+/**
+ * Draws the profiler's results on screen. Compiles to nothing unless the game
+ * is built with -DPROFILE (run 'make PROFILE=true').
+ */
+#ifdef PROFILE
+#define PROFILE_OVERLAY(font) profiler_render_overlay(font)
+#else
+#define PROFILE_OVERLAY(font) ((void)0)
+#endif
+
+/**
+ * Draws the profiler overlay in the top left of the screen: a bar for the
+ * last frame with one colored segment per stage, the rolling average of
+ * every stage below it, and the average, shortest and longest time between
+ * ticks from timer_get_frame_stats().
+ *
+ * @param font the font for the stage names and times
+ */
+void profiler_render_overlay(TTF_Font *font);
+
+#endif // #ifndef __PROFILER_OVERLAY_H__
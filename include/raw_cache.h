@@ -0,0 +1,48 @@
+#ifndef __RAW_CACHE_H__
+#define __RAW_CACHE_H__
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+
+/**
+ * An on-disk cache of decoded images, so a cold start doesn't spend its time
+ * inflating PNGs.
+ *
+ * The first time an image is decoded, its RGBA pixels are written next to it
+ * as <path>.raw (e.g. assets/wizzy.png.raw), along with a hash of the PNG's
+ * bytes. Later loads whose PNG still has that hash read the pixels straight
+ * into a surface, with no decompression. A changed PNG no longer matches, so
+ * it is decoded again and its .raw file rewritten. Images found in the asset
+ * archive are hashed from the archive.
+ *
+ * The cache is skipped under emscripten, whose files don't outlive the page,
+ * and when the RAW_CACHE environment variable is 0. If a .raw file can't be
+ * written (e.g. the directory is read-only), the image is still loaded.
+ */
+#define RAW_CACHE_MAGIC "RMDRAW\0\0"
+#define RAW_CACHE_VERSION 1
+
+/**
+ * The start of a .raw file, followed by height rows of width RGBA32 pixels.
+ */
+typedef struct raw_cache_header {
+  char magic[8]; // RAW_CACHE_MAGIC
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t reserved;
+  uint64_t source_hash; // 64-bit FNV-1a of the PNG's bytes
+  uint64_t source_size;
+} raw_cache_header_t;
+
+/**
+ * Loads an image, from its .raw file if that is up to date, otherwise by
+ * decoding it and then writing the .raw file.
+ * Safe to call from any thread, though not twice at once for the same path.
+ *
+ * @param path the image's path
+ * @return the image as an RGBA32 surface, or NULL if it couldn't be loaded
+ */
+SDL_Surface *raw_cache_load(const char *path);
+
+#endif // #ifndef __RAW_CACHE_H__
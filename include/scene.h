@@ -65,6 +65,15 @@ void scene_free(scene_t *scene);
  */
 size_t scene_bodies(scene_t *scene);
 
+/**
+ * Gets the number of force creators in a given scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of force creators that haven't been removed along with
+ * their bodies
+ */
+size_t scene_force_creators(scene_t *scene);
+
 /**
  * Gets the body at a given index in a scene.
  * Asserts that the index is valid.
@@ -29,6 +29,16 @@ typedef enum {
  */
 SDL_Rect sdl_get_bounding_box(body_t *body);
 
+/**
+ * Gets the bounding box for a body, shifted to where the body appears
+ * between its last two simulation steps (see body_get_interpolated_centroid).
+ *
+ * @param body a body object
+ * @param alpha how far to blend, from 0 (previous position) to 1 (current)
+ * @return the bounding box of the body at its interpolated position
+ */
+SDL_Rect sdl_get_interpolated_bounding_box(body_t *body, double alpha);
+
 /**
  * The possible types of key events.
  * Enum types in C are much more primitive than in Java; this is equivalent to:
@@ -85,6 +95,10 @@ void sdl_stop_music();
  * Initializes the SDL window, renderer, and music mixers.
  * Must be called once before any of the other SDL functions.
  *
+ * When compiled with -DHEADLESS, no window, renderer, fonts or audio are
+ * created. The drawing functions then do nothing, so the game can be
+ * simulated without a display.
+ *
  * @param min the x and y coordinates of the bottom left of the scene
  * @param max the x and y coordinates of the top right of the scene
  */
@@ -136,8 +150,149 @@ void sdl_render_image(SDL_Texture *texture, SDL_Rect image_rect);
 
 void sdl_render_image_rotated(SDL_Texture *texture, SDL_Rect image_rect, double angle);
 
+/**
+ * An image to draw: a texture and the part of it the image takes up, so many
+ * images can share one texture (see atlas.h).
+ */
+typedef struct sprite {
+  SDL_Texture *texture; // NULL if the image isn't loaded
+  SDL_Rect src;
+} sprite_t;
+
+/**
+ * The layers sprites are drawn in, from back to front.
+ */
+typedef enum {
+  LAYER_BACKGROUND,
+  LAYER_WORLD,
+  LAYER_PROJECTILES,
+  LAYER_HUD,
+  LAYER_OVERLAY,
+  LAYER_COUNT
+} render_layer_t;
+
+/**
+ * Draws a sprite rotated about its center.
+ *
+ * Sprites are queued rather than drawn right away. When the queue is flushed
+ * it is radix sorted by layer and then by texture, so each layer is drawn
+ * over the ones before it and the sprites in a layer take one
+ * SDL_RenderGeometry call per texture (e.g. per atlas page). Sprites in the
+ * same layer and texture keep the order they were drawn in, but overlapping
+ * sprites from different textures in the same layer may swap.
+ *
+ * The queue is flushed when anything else is drawn or the frame is shown,
+ * so layers only order the sprites drawn in between.
+ *
+ * @param sprite the sprite; nothing is drawn if its texture is NULL
+ * @param image_rect where to draw it
+ * @param angle the clockwise rotation in degrees
+ * @param layer the layer to draw it in
+ */
+void sdl_render_sprite(const sprite_t *sprite, SDL_Rect image_rect,
+                       double angle, render_layer_t layer);
+
+/**
+ * Draws every queued sprite. The sdl_* drawing functions do this
+ * themselves; call it before drawing with the renderer directly.
+ */
+void sdl_flush_sprites(void);
+
+/**
+ * Makes a blank, fully transparent RGBA32 texture that can be drawn with
+ * alpha blending and filled in with SDL_UpdateTexture().
+ *
+ * @param width the width in pixels
+ * @param height the height in pixels
+ * @return the texture, or NULL if there is no renderer
+ */
+SDL_Texture *sdl_create_texture(int width, int height);
+
+/**
+ * Makes a texture the size of the window that can be drawn into, between
+ * sdl_begin_render_target() and sdl_end_render_target(), and then drawn like
+ * any other texture. Its contents are lost whenever
+ * sdl_get_render_target_generation() changes.
+ *
+ * @return the texture, or NULL if there is no renderer or it can't draw into
+ * textures
+ */
+SDL_Texture *sdl_create_render_target(void);
+
+/**
+ * Clears a texture from sdl_create_render_target() to transparent and sends
+ * everything drawn into it until sdl_end_render_target(), including with
+ * the other sdl_* drawing functions.
+ *
+ * @param target the texture to draw into
+ */
+void sdl_begin_render_target(SDL_Texture *target);
+
+/**
+ * Goes back to drawing to the window.
+ */
+void sdl_end_render_target(void);
+
+/**
+ * Gets a count that changes whenever textures from sdl_create_render_target()
+ * must be remade and redrawn: when the window is resized, or the renderer
+ * loses their contents.
+ *
+ * @return the count
+ */
+size_t sdl_get_render_target_generation(void);
+
 SDL_Texture *image_to_texture(const char *file_path);
 
+/**
+ * Decodes an image file into a surface, without touching the renderer, so
+ * it can be called from any thread. Goes through the decoded image cache in
+ * raw_cache.h.
+ *
+ * @param file_path the path to the image
+ * @return the decoded surface, or NULL if it couldn't be loaded or there is
+ * no renderer to draw it with (e.g. when headless)
+ */
+SDL_Surface *image_to_surface(const char *file_path);
+
+/**
+ * Uploads a surface to a texture. Must be called from the main thread.
+ * Frees the surface.
+ *
+ * @param surface the surface to upload, or NULL
+ * @return the texture, or NULL if `surface` is NULL or there is no renderer
+ */
+SDL_Texture *surface_to_texture(SDL_Surface *surface);
+
+/**
+ * Rasterizes a line of text to a texture, the same way sdl_render_text_color()
+ * draws it, so it can be drawn again without rendering the text each time.
+ *
+ * @param txt the text
+ * @param font the font to render it with
+ * @param color the color of the text
+ * @return the texture, sized to the text, or NULL if there is no renderer or
+ * font or the text is empty
+ */
+SDL_Texture *text_to_texture(const char *txt, TTF_Font *font, SDL_Color color);
+
+/**
+ * Opens a font, from the asset archive if it holds the font.
+ *
+ * @param file_path the path to the font
+ * @param size the point size to open it at
+ * @return the font, or NULL if it couldn't be loaded
+ */
+TTF_Font *load_font(const char *file_path, int size);
+
+/**
+ * Gets the height of a font's characters in pixels.
+ *
+ * @param font the font, or NULL if it couldn't be loaded (e.g. when headless)
+ * @return the font height, or 0 if font is NULL
+ */
+int sdl_font_height(TTF_Font *font);
+
 /**
  * Registers a function to be called every time a key is pressed.
  * Overwrites any existing handler.
@@ -175,11 +330,51 @@ void sdl_on_mouse(mouse_handler_t m_handler);
 /**
  * Gets the amount of time that has passed since the last time
  * this function was called, in seconds.
+ * Measured with the monotonic wall clock in timer.h, and recorded in its
+ * frame statistics.
  *
  * @return the number of seconds that have elapsed
  */
 double time_since_last_tick(void);
 
+/**
+ * Restarts the clock used by time_since_last_tick() without counting the
+ * skipped time as a frame. Call after the loop has been idle, e.g. waiting in
+ * sdl_wait_event(), so the next tick doesn't see one huge time step.
+ */
+void reset_tick_timer(void);
+
+/**
+ * Checks whether the screen needs to be drawn again because of input or
+ * because the window was exposed, resized, or otherwise changed since the
+ * last call. Clears the request.
+ *
+ * @return true if a redraw was requested, false otherwise
+ */
+bool sdl_redraw_requested(void);
+
+/**
+ * Asks for the screen to be drawn again; see sdl_redraw_requested().
+ */
+void sdl_request_redraw(void);
+
+/**
+ * Blocks until an SDL event arrives or the timeout expires, without removing
+ * the event from the queue. Lets the main loop sleep while nothing changes.
+ * Returns immediately under emscripten, where the browser can't block.
+ *
+ * @param timeout the longest time to wait, in seconds
+ */
+void sdl_wait_event(double timeout);
+
+
+/**
+ * Fills a rectangle with a solid color.
+ *
+ * @param rect the rectangle to fill, in window coordinates
+ * @param color the color to fill it with
+ */
+void sdl_draw_rect(SDL_Rect rect, SDL_Color color);
 
 /**
  * Draws the bars.
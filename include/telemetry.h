@@ -0,0 +1,92 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <stdint.h>
+
+#include "profiler.h"
+
+/**
+ * Records one fixed-width record per frame to telemetry.bin, for balancing
+ * and capacity planning. tools/telemetry_csv.c turns the file into a CSV
+ * (run 'make bin/telemetry_csv', then 'bin/telemetry_csv telemetry.bin').
+ *
+ * Records are copied into one of two buffers allocated by telemetry_init().
+ * When that buffer fills up, a background thread writes it out while the game
+ * fills the other one, so a frame never waits on the disk unless the writer
+ * is a whole buffer behind. Under emscripten, or if the thread can't be
+ * started, full buffers are written inline instead.
+ *
+ * The TELEMETRY_* macros compile to nothing unless the game is built with
+ * -DTELEMETRY (run 'make TELEMETRY=true'), and TELEMETRY_RECORD doesn't
+ * evaluate its argument then, so sampling costs nothing in a normal build.
+ * Stage timings come from the profiler, which TELEMETRY turns on.
+ */
+#ifdef TELEMETRY
+#define TELEMETRY_INIT() telemetry_init()
+#define TELEMETRY_FINISH() telemetry_finish()
+#define TELEMETRY_RECORD(record) telemetry_record(record)
+#else
+#define TELEMETRY_INIT() ((void)0)
+#define TELEMETRY_FINISH() ((void)0)
+#define TELEMETRY_RECORD(record) ((void)0)
+#endif
+
+#define TELEMETRY_MAGIC "RMDTELEM"
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_STAGE_NAME_SIZE 16
+
+/**
+ * The start of a telemetry file. The stage names are stored so the converter
+ * doesn't need the profiler.
+ */
+typedef struct telemetry_header {
+  char magic[8]; // TELEMETRY_MAGIC, without the null terminator
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t stage_count;
+  uint32_t reserved;
+  char stage_names[PROFILE_STAGE_COUNT][TELEMETRY_STAGE_NAME_SIZE];
+} telemetry_header_t;
+
+/**
+ * One frame of telemetry. The caller fills in everything from dt onward;
+ * frame, tick and time are filled in by telemetry_record().
+ */
+typedef struct telemetry_record {
+  uint64_t frame; // Frames recorded before this one
+  uint64_t tick;  // Simulation steps taken before this frame
+  double time;    // Seconds since telemetry_init() at the end of the frame
+  float dt;       // Time since the previous frame, in seconds
+  uint32_t steps; // Simulation steps taken in this frame
+  uint32_t bodies;
+  uint32_t projectiles;
+  uint32_t enemies;
+  uint32_t force_creators;
+  uint32_t assets;
+  uint32_t player_health;
+  uint32_t player_exp;
+  uint32_t player_level;
+  int32_t boss_health; // -1 while there is no boss
+  float stages[PROFILE_STAGE_COUNT]; // Seconds spent in each stage
+} telemetry_record_t;
+
+/**
+ * Opens telemetry.bin in the working directory, writes its header and
+ * starts the writer thread. Does nothing if telemetry is already recording.
+ */
+void telemetry_init(void);
+
+/**
+ * Adds a frame to the buffer. Does nothing if telemetry_init() wasn't called.
+ *
+ * @param record the frame's values; see telemetry_record_t
+ */
+void telemetry_record(telemetry_record_t record);
+
+/**
+ * Writes out every buffered record, stops the writer thread and closes the
+ * file. Does nothing if telemetry_init() wasn't called.
+ */
+void telemetry_finish(void);
+
+#endif // #ifndef __TELEMETRY_H__
@@ -11,10 +11,12 @@
 
 /**
  * Returns whether two double values are nearly equal,
- * i.e. within 10 ** -7 of each other.
+ * i.e. within SCALAR_EPSILON of each other (10 ** -7 in the default double
+ * build, 10 ** -4 when vector components are single precision).
  * Floating-point math is approximate, so isclose() is preferable to ==.
- * There are some exceptions: ints (<= 53 bits) and fractions whose denominators
- * are powers of 2 (e.g. 0.5 or 0.75) can be represented exactly as a double.
+ * There are some exceptions: ints (<= 53 bits, or <= 24 bits for float) and
+ * fractions whose denominators are powers of 2 (e.g. 0.5 or 0.75) can be
+ * represented exactly.
  */
 bool isclose(double d1, double d2);
 
@@ -27,9 +29,9 @@ bool vec_equal(vector_t v1, vector_t v2);
 
 /**
  * Return if two vectors are close to each other; that is, if the corresponding
- * components are within 1e-7 of each other.
+ * components are within SCALAR_EPSILON of each other.
  * This may be more useful than vec_equal, because vector components are
- * doubles, not integers, and floating-point math is approximate.
+ * floating-point, not integers, and floating-point math is approximate.
  */
 bool vec_isclose(vector_t v1, vector_t v2);
 
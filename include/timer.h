@@ -0,0 +1,50 @@
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#include <stddef.h>
+
+/**
+ * Summary of the most recent frame times, in seconds.
+ * Covers at most the last 120 frames recorded with timer_record_frame().
+ */
+typedef struct {
+  double last;
+  double min;
+  double max;
+  double mean;
+  size_t frames;
+} frame_stats_t;
+
+/**
+ * Reads a high-resolution monotonic clock.
+ * Unlike clock(), this measures elapsed wall time rather than CPU time, so it
+ * keeps counting while the process sleeps or waits for vsync.
+ *
+ * @return the number of seconds since the first call to timer_now()
+ */
+double timer_now(void);
+
+/**
+ * Records how long a frame took, for timer_get_frame_stats().
+ *
+ * @param frame_time the length of the frame in seconds
+ */
+void timer_record_frame(double frame_time);
+
+/**
+ * Gets statistics over the most recently recorded frames.
+ *
+ * @return the frame time statistics; all zero if no frames were recorded
+ */
+frame_stats_t timer_get_frame_stats(void);
+
+/**
+ * Sleeps until at least 1 / max_fps seconds have passed since the previous
+ * call, so a native build doesn't spin a core redrawing frames nobody sees.
+ * Does nothing under emscripten, where the browser paces the main loop.
+ *
+ * @param max_fps the maximum number of frames per second
+ */
+void timer_limit_frame(double max_fps);
+
+#endif // #ifndef __TIMER_H__
@@ -0,0 +1,91 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stddef.h>
+
+/**
+ * Records a timeline of the game in the Chrome trace-event format, which can
+ * be opened in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Events are appended to a ring buffer allocated up front by trace_init() and
+ * are only written out by trace_finish(), so recording never allocates or does
+ * I/O in the middle of a frame. Once the buffer is full, each new event
+ * overwrites the oldest, so a long session keeps its last few minutes. Event
+ * names must be string literals (or otherwise outlive the trace), since only
+ * the pointer is stored.
+ *
+ * The TRACE_* macros compile to nothing unless the game is built with
+ * -DTRACE (run 'make TRACE=true'). Stages timed with PROFILE_BEGIN and
+ * PROFILE_END in profiler.h are also traced. Under emscripten the file would
+ * only be written to the browser's in-memory file system, where nothing can
+ * read it, so the recorder is left out there; trace the native build instead.
+ */
+#if defined(TRACE) && !defined(__EMSCRIPTEN__)
+#define TRACE_INIT() trace_init()
+#define TRACE_FINISH() trace_finish()
+#define TRACE_BEGIN(name) trace_begin(name)
+#define TRACE_END(name) trace_end(name)
+#define TRACE_COUNTER(name, value) trace_counter(name, value)
+#define TRACE_INSTANT(name) trace_instant(name)
+#else
+#define TRACE_INIT() ((void)0)
+#define TRACE_FINISH() ((void)0)
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+#define TRACE_INSTANT(name) ((void)0)
+#endif
+
+/**
+ * Allocates the event buffer and starts recording.
+ * Calling it again discards everything recorded so far.
+ */
+void trace_init(void);
+
+/**
+ * Writes every recorded event to trace.json in the working directory and
+ * frees the buffer. Does nothing if trace_init() wasn't called.
+ */
+void trace_finish(void);
+
+/**
+ * Marks the start of a span, e.g. a stage of the frame.
+ * Spans must nest: each trace_end() closes the latest open span.
+ *
+ * @param name the name of the span
+ */
+void trace_begin(const char *name);
+
+/**
+ * Marks the end of the span opened by the matching trace_begin().
+ *
+ * @param name the name of the span
+ */
+void trace_end(const char *name);
+
+/**
+ * Records the value of a counter, drawn as a graph over time.
+ *
+ * @param name the name of the counter
+ * @param value the current value
+ */
+void trace_counter(const char *name, double value);
+
+/**
+ * Records a one-off event, e.g. the boss spawning.
+ *
+ * @param name the name of the event
+ */
+void trace_instant(const char *name);
+
+/**
+ * Records an event at a time read by the caller, so a time that was already
+ * measured doesn't have to be read from the clock again.
+ *
+ * @param phase 'B' to begin a span or 'E' to end one
+ * @param name the name of the span
+ * @param time the time of the event, from timer_now()
+ */
+void trace_span_at(char phase, const char *name, double time);
+
+#endif // #ifndef __TRACE_H__
@@ -1,14 +1,35 @@
 #ifndef __VECTOR_H__
 #define __VECTOR_H__
 
+#include <float.h>
+
+/**
+ * The real number type used for vector components and the physics built on
+ * them. Defaults to double; building with -DVECTOR_SINGLE_PRECISION (or
+ * `make SINGLE_PRECISION=true`) switches the whole library to float, which
+ * halves the memory per vertex and doubles the SIMD width.
+ *
+ * SCALAR_MAX is the largest finite scalar_t and SCALAR_EPSILON is the
+ * tolerance that approximate comparisons on scalar_t values should use.
+ */
+#ifdef VECTOR_SINGLE_PRECISION
+typedef float scalar_t;
+#define SCALAR_MAX FLT_MAX
+#define SCALAR_EPSILON 1e-4
+#else
+typedef double scalar_t;
+#define SCALAR_MAX DBL_MAX
+#define SCALAR_EPSILON 1e-7
+#endif
+
 /**
  * A real-valued 2-dimensional vector.
  * Positive x is towards the right; positive y is towards the top.
  * vector_t is defined here instead of vector.c because it is passed *by value*.
  */
 typedef struct {
-  double x;
-  double y;
+  scalar_t x;
+  scalar_t y;
 } vector_t;
 
 /**
@@ -55,7 +76,7 @@ vector_t vec_negate(vector_t v);
  * @param v the vector to scale
  * @return scalar * v
  */
-vector_t vec_multiply(double scalar, vector_t v);
+vector_t vec_multiply(scalar_t scalar, vector_t v);
 
 /**
  * Computes the dot product of two vectors.
@@ -65,7 +86,7 @@ vector_t vec_multiply(double scalar, vector_t v);
  * @param v2 the second vector
  * @return v1 . v2
  */
-double vec_dot(vector_t v1, vector_t v2);
+scalar_t vec_dot(vector_t v1, vector_t v2);
 
 /**
  * Computes the cross product of two vectors,
@@ -76,7 +97,7 @@ double vec_dot(vector_t v1, vector_t v2);
  * @param v2 the second vector
  * @return the z-component of v1 x v2
  */
-double vec_cross(vector_t v1, vector_t v2);
+scalar_t vec_cross(vector_t v1, vector_t v2);
 
 /**
  * Rotates a vector by an angle around (0, 0).
@@ -90,24 +111,24 @@ double vec_cross(vector_t v1, vector_t v2);
  * @param angle the angle to rotate the vector
  * @return v rotated by the given angle
  */
-vector_t vec_rotate(vector_t v, double angle);
+vector_t vec_rotate(vector_t v, scalar_t angle);
 
 /**
  * Calculate the length of a vector.
  *
  * @param v the vector to calculate the length of
- * @return a double representing the vector's magnitude
+ * @return a scalar representing the vector's magnitude
  */
-double vec_get_length(vector_t v);
+scalar_t vec_get_length(vector_t v);
 
 /**
  * Calculate the ange between two vectors.
  *
  * @param v1 the first vec to find the angle between
  * @param v2 the second vec to find the angle between
- * @return a double representing the vector's difference in angle
+ * @return a scalar representing the vector's difference in angle
  */
-double vec_angle_between(vector_t v1, vector_t v2);
+scalar_t vec_angle_between(vector_t v1, vector_t v2);
 
 
 #endif // #ifndef __VECTOR_H__
@@ -0,0 +1,133 @@
+#ifndef __VECTOR_BATCH_H__
+#define __VECTOR_BATCH_H__
+
+#include "list.h"
+#include "vector.h"
+#include <stddef.h>
+
+/**
+ * Array kernels that apply the vector.h operations to many points at once.
+ * Points are stored as two contiguous arrays (x[] and y[]) so the kernels can
+ * use SSE2 or AVX2 when the CPU supports it. The best available path is
+ * picked at runtime when the program starts; non-x86 targets
+ * (including emscripten) always use the scalar path.
+ */
+
+/**
+ * Number of points a vec_batch_t can hold without allocating.
+ * Every hitbox in the game is a quadrilateral, so this covers all of them.
+ */
+#define VEC_BATCH_INLINE 16
+
+/**
+ * A structure-of-arrays copy of a list of points.
+ * Small batches live entirely inside the struct; larger ones allocate.
+ */
+typedef struct {
+  scalar_t *x;
+  scalar_t *y;
+  size_t size;
+  scalar_t inline_x[VEC_BATCH_INLINE];
+  scalar_t inline_y[VEC_BATCH_INLINE];
+} vec_batch_t;
+
+/**
+ * Prepares a batch with room for the given number of points.
+ * The contents of x and y are undefined until they are written.
+ * Must be paired with vec_batch_release().
+ *
+ * @param batch the batch to initialize
+ * @param size the number of points the batch will hold
+ */
+void vec_batch_init(vec_batch_t *batch, size_t size);
+
+/**
+ * Prepares a batch holding a copy of every vector in a list.
+ * Must be paired with vec_batch_release().
+ *
+ * @param batch the batch to initialize
+ * @param points a list of vector_t *, e.g. from polygon_get_points()
+ */
+void vec_batch_from_list(vec_batch_t *batch, list_t *points);
+
+/**
+ * Writes the points of a batch back into the vectors of a list.
+ * The list must have the same size as the batch.
+ *
+ * @param batch a batch returned from vec_batch_from_list()
+ * @param points the list of vector_t * to overwrite
+ */
+void vec_batch_to_list(vec_batch_t *batch, list_t *points);
+
+/**
+ * Releases any memory allocated by a batch.
+ *
+ * @param batch a batch initialized with vec_batch_init() or
+ * vec_batch_from_list()
+ */
+void vec_batch_release(vec_batch_t *batch);
+
+/**
+ * Adds a vector to every point.
+ *
+ * @param x the x components, updated in place
+ * @param y the y components, updated in place
+ * @param n the number of points
+ * @param translation the vector to add to each point
+ */
+void vec_batch_translate(scalar_t *x, scalar_t *y, size_t n,
+                         vector_t translation);
+
+/**
+ * Rotates every point by an angle around a pivot.
+ * cos and sin are evaluated once for the whole array.
+ *
+ * @param x the x components, updated in place
+ * @param y the y components, updated in place
+ * @param n the number of points
+ * @param angle the angle to rotate by, in radians (counterclockwise)
+ * @param pivot the point to rotate around
+ */
+void vec_batch_rotate(scalar_t *x, scalar_t *y, size_t n, scalar_t angle,
+                      vector_t pivot);
+
+/**
+ * Projects every point onto an axis and reduces to the extreme projections.
+ * Asserts that n is positive.
+ *
+ * @param x the x components
+ * @param y the y components
+ * @param n the number of points
+ * @param axis the axis to dot each point with (normally a unit vector)
+ * @return a vector in the form (max, min) of the projections
+ */
+vector_t vec_batch_project_max_min(const scalar_t *x, const scalar_t *y,
+                                   size_t n, vector_t axis);
+
+/**
+ * Computes the length of every vector.
+ *
+ * @param x the x components
+ * @param y the y components
+ * @param n the number of vectors
+ * @param lengths an array of n scalars to store the lengths in
+ */
+void vec_batch_length(const scalar_t *x, const scalar_t *y, size_t n,
+                      scalar_t *lengths);
+
+/**
+ * Scales every vector to unit length. Zero vectors are left as zero.
+ *
+ * @param x the x components, updated in place
+ * @param y the y components, updated in place
+ * @param n the number of vectors
+ */
+void vec_batch_normalize(scalar_t *x, scalar_t *y, size_t n);
+
+/**
+ * Returns the name of the kernel path selected for this CPU
+ * ("avx2", "sse2" or "scalar"), mostly for benchmark output.
+ */
+const char *vec_batch_backend(void);
+
+#endif // #ifndef __VECTOR_BATCH_H__
@@ -14,6 +14,7 @@ typedef struct asset {
 
 typedef struct text_asset {
   asset_t base;
+  const char *font_path;
   TTF_Font *font;
   const char *text;
   rgb_color_t color;
@@ -21,9 +22,11 @@ typedef struct text_asset {
 
 typedef struct image_asset {
   asset_t base;
-  SDL_Texture *texture;
+  const char *filepath;
+  const sprite_t *sprite; // Updated in place by the asset cache
   body_t *body;
   double angle; // Add angle to the struct
+  render_layer_t layer;
 } image_asset_t;
 
 typedef struct button_asset {
@@ -70,8 +73,11 @@ static asset_t *asset_init(asset_type_t ty, SDL_Rect bounding_box) {
 asset_t *asset_make_image_with_body(const char *filepath, SDL_Rect bounding_box,
                                     body_t *body) {
   image_asset_t *img = (image_asset_t *)asset_init(ASSET_IMAGE, bounding_box);
-  img->texture = asset_cache_obj_get_or_create(ASSET_IMAGE, filepath);
+  img->filepath = filepath;
+  img->sprite = asset_cache_acquire(ASSET_IMAGE, filepath);
   img->body = body; // Set body to the given body
+  img->angle = 0;
+  img->layer = LAYER_WORLD;
 
   return (asset_t *)img;
 }
@@ -79,9 +85,11 @@ asset_t *asset_make_image_with_body(const char *filepath, SDL_Rect bounding_box,
 asset_t *asset_make_image_with_body_angle(const char *filepath, SDL_Rect bounding_box,
                                     body_t *body, double angle) { // Add angle parameter
   image_asset_t *img = (image_asset_t *)asset_init(ASSET_IMAGE, bounding_box);
-  img->texture = asset_cache_obj_get_or_create(ASSET_IMAGE, filepath);
+  img->filepath = filepath;
+  img->sprite = asset_cache_acquire(ASSET_IMAGE, filepath);
   img->body = body; // Set body to the given body
   img->angle = angle; // Initialize angle
+  img->layer = LAYER_WORLD;
 
   return (asset_t *)img;
 }
@@ -101,7 +109,8 @@ asset_t *asset_make_text(const char *filepath, SDL_Rect bounding_box,
 
   txt->color = color;
   txt->text = text;
-  txt->font = asset_cache_obj_get_or_create(ASSET_FONT, filepath);
+  txt->font_path = filepath;
+  txt->font = asset_cache_acquire(ASSET_FONT, filepath);
 
   return (asset_t *)txt;
 }
@@ -127,6 +136,11 @@ body_t *asset_get_body(asset_t *asset) {
   return img_asset->body;
 }
 
+void asset_set_layer(asset_t *image_asset, render_layer_t layer) {
+  assert(asset_get_type(image_asset) == ASSET_IMAGE);
+  ((image_asset_t *)image_asset)->layer = layer;
+}
+
 void asset_on_button_click(asset_t *button, state_t *state, double x,
                            double y) {
   button_asset_t *current_button = (button_asset_t *)button;
@@ -148,7 +162,8 @@ void asset_on_button_click(asset_t *button, state_t *state, double x,
 void asset_image_render(asset_t *asset) {
   image_asset_t *img_asset = (image_asset_t *) asset;
   // Render image with rotation
-  sdl_render_image_rotated(img_asset->texture, asset->bounding_box, img_asset->angle); 
+  sdl_render_sprite(img_asset->sprite, asset->bounding_box, img_asset->angle,
+                    img_asset->layer);
 }
 
 void asset_text_render(asset_t *asset) {
@@ -156,13 +171,16 @@ void asset_text_render(asset_t *asset) {
   sdl_render_text(txt_asset->text, txt_asset->font, asset->bounding_box);
 }
 
-void asset_render(asset_t *asset) {
+void asset_render(asset_t *asset) { asset_render_interpolated(asset, 1.0); }
+
+void asset_render_interpolated(asset_t *asset, double alpha) {
   switch (asset->type) {
   case ASSET_IMAGE: {
     image_asset_t *img_asset = (image_asset_t *)asset;
     if (img_asset->body != NULL) {
       // Set the bounding box to the body's bounding box      
-      asset->bounding_box = sdl_get_bounding_box(img_asset->body);
+      asset->bounding_box =
+          sdl_get_interpolated_bounding_box(img_asset->body, alpha);
     }
     asset_image_render(asset);
     break;
@@ -185,4 +203,23 @@ void asset_render(asset_t *asset) {
   }
 }
 
-void asset_destroy(asset_t *asset) { free(asset); }
\ No newline at end of file
+void asset_destroy(asset_t *asset) {
+  if (asset == NULL) {
+    return;
+  }
+  switch (asset->type) {
+  case ASSET_IMAGE: {
+    asset_cache_release(ASSET_IMAGE, ((image_asset_t *)asset)->filepath);
+    break;
+  }
+  case ASSET_FONT: {
+    asset_cache_release(ASSET_FONT, ((text_asset_t *)asset)->font_path);
+    break;
+  }
+  case ASSET_BUTTON: {
+    // The button's image and text belong to the caller
+    break;
+  }
+  }
+  free(asset);
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "asset_archive.h"
+#include "log.h"
+
+/**
+ * The mapped archive, or NULL if there is none. entries points into it.
+ */
+static const uint8_t *archive = NULL;
+static size_t archive_size = 0;
+static const asset_archive_entry_t *entries = NULL;
+static size_t num_entries = 0;
+static bool close_registered = false;
+
+/**
+ * Checks that every index entry and its path lie within the archive.
+ */
+static bool archive_is_valid(void) {
+  if (archive_size < sizeof(asset_archive_header_t)) {
+    return false;
+  }
+  const asset_archive_header_t *header = (const void *)archive;
+  if (memcmp(header->magic, ASSET_ARCHIVE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != ASSET_ARCHIVE_VERSION ||
+      header->count > (archive_size - sizeof(*header)) /
+                          sizeof(asset_archive_entry_t)) {
+    return false;
+  }
+
+  const asset_archive_entry_t *index_entries = (const void *)(header + 1);
+  for (size_t i = 0; i < header->count; i++) {
+    const asset_archive_entry_t *entry = &index_entries[i];
+    if (entry->offset > archive_size ||
+        entry->size > archive_size - entry->offset ||
+        entry->path_offset > archive_size ||
+        entry->path_size > archive_size - entry->path_offset ||
+        (i > 0 && index_entries[i - 1].hash > entry->hash)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool asset_archive_open(const char *path) {
+  asset_archive_close();
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  void *mapped = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  // The mapping stays valid after the file is closed
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    LOG_WARN("can't map %s; loading assets from their own files", path);
+    return false;
+  }
+
+  archive = mapped;
+  archive_size = info.st_size;
+  if (!archive_is_valid()) {
+    LOG_WARN("%s isn't a valid asset archive; loading assets from their own "
+             "files",
+             path);
+    asset_archive_close();
+    return false;
+  }
+  const asset_archive_header_t *header = (const void *)archive;
+  entries = (const void *)(header + 1);
+  num_entries = header->count;
+
+  if (!close_registered) {
+    atexit(asset_archive_close);
+    close_registered = true;
+  }
+  return true;
+}
+
+void asset_archive_close(void) {
+  if (archive != NULL) {
+    munmap((void *)archive, archive_size);
+  }
+  archive = NULL;
+  archive_size = 0;
+  entries = NULL;
+  num_entries = 0;
+}
+
+const void *asset_archive_find(const char *path, size_t *size) {
+  if (archive == NULL) {
+    return NULL;
+  }
+  uint64_t hash = asset_archive_hash(path);
+
+  // Find the first entry with the hash, then check the paths of every entry
+  // that shares it
+  size_t low = 0;
+  size_t high = num_entries;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (entries[mid].hash < hash) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  size_t path_size = strlen(path);
+  for (size_t i = low; i < num_entries && entries[i].hash == hash; i++) {
+    const asset_archive_entry_t *entry = &entries[i];
+    if (entry->path_size == path_size &&
+        memcmp(archive + entry->path_offset, path, path_size) == 0) {
+      *size = entry->size;
+      return archive + entry->offset;
+    }
+  }
+  return NULL;
+}
+
+SDL_RWops *asset_archive_rw(const char *path) {
+  size_t size;
+  const void *data = asset_archive_find(path, &size);
+  if (data == NULL) {
+    return SDL_RWFromFile(path, "rb");
+  }
+  return SDL_RWFromConstMem(data, size);
+}
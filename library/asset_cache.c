@@ -1,104 +1,644 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
 #include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "asset.h"
+#include "asset_archive.h"
 #include "asset_cache.h"
+#include "atlas.h"
 #include "list.h"
 #include "sdl_wrapper.h"
-
-static list_t *ASSET_CACHE;
+#include "timer.h"
 
 const size_t FONT_SIZE = 18;
 const size_t INITIAL_CAPACITY = 5;
+// Must be a power of two; tables double whenever they get 3/4 full
+const size_t INITIAL_TABLE_CAPACITY = 32;
+// Must be a power of two
+#define ASSET_ALIAS_SLOTS 64
+// Assumed when SDL doesn't report a texture's pixel format
+const size_t DEFAULT_BYTES_PER_PIXEL = 4;
+const size_t ASSET_BYTES_PER_MB = 1 << 20;
+const size_t ASSET_DECODE_THREADS = 2;
+// Built by 'make assets.pack'; assets are loaded from their own files without it
+const char *ASSET_ARCHIVE_PATH = "assets.pack";
 
-typedef struct {
+typedef enum {
+  ENTRY_UNLOADED,
+  ENTRY_PENDING, // Queued for decoding, being decoded or waiting for upload
+  ENTRY_LOADED,  // obj may still be NULL, e.g. when headless
+} entry_status_t;
+
+typedef struct entry {
   asset_type_t type;
-  const char *filepath;
-  void *obj;
+  const char *filepath; // The interned copy of the path
+  void *obj; // The font; images are drawn from `sprite`
+  sprite_t sprite;
+  bool in_atlas; // Atlased images can't be freed on their own
+  entry_status_t status;
+  SDL_Surface *surface; // Set by a decoder thread, uploaded by the pump
+  size_t refcount;
+  size_t bytes; // Approximate size of a loaded texture, 0 for fonts and
+                // atlased images
+  // Neighbors in the LRU list, which only holds loaded, unreferenced images
+  struct entry *lru_prev;
+  struct entry *lru_next;
+  bool in_lru;
 } entry_t;
 
-static void asset_cache_free_entry(entry_t *entry) {
-  switch (entry->type) {
-  case ASSET_IMAGE: {
-    SDL_DestroyTexture(entry->obj);
-    break;
+/**
+ * An open-addressing hash table with linear probing. A slot is empty when its
+ * key is NULL. Nothing is ever removed.
+ */
+typedef struct {
+  const void *key;
+  void *value;
+} slot_t;
+
+typedef struct {
+  slot_t *slots;
+  size_t capacity;
+  size_t size;
+} table_t;
+
+/**
+ * The interned paths, keyed and compared by their contents.
+ * Each key is also its own value.
+ */
+static table_t paths;
+/**
+ * Recently passed path pointers and their interned copies, as a small
+ * direct-mapped cache indexed by address. Callers pass the same string
+ * literals over and over, so most lookups are found here by comparing one
+ * pointer, without reading the path. That is only sound because paths never
+ * change (see asset_cache.h). A new pointer replaces whatever shared its
+ * slot, so the cache stays the same size however many paths are passed.
+ */
+typedef struct {
+  const char *filepath;
+  const char *interned;
+} alias_t;
+
+static alias_t aliases[ASSET_ALIAS_SLOTS];
+/**
+ * The image and font entries, keyed by interned path.
+ */
+static table_t textures;
+static table_t fonts;
+/**
+ * The registered buttons, owned by the cache.
+ */
+static list_t *buttons = NULL;
+/**
+ * The unreferenced images, least recently used first. They are evicted from
+ * the front whenever the loaded textures take more than `budget` bytes.
+ */
+static entry_t *lru_head = NULL;
+static entry_t *lru_tail = NULL;
+static size_t texture_bytes = 0; // Not counting the atlas
+static size_t budget = SIZE_MAX;
+/**
+ * Drawn in place of images that are still being decoded, or NULL until one
+ * is needed.
+ */
+static SDL_Texture *placeholder = NULL;
+
+/**
+ * Images waiting to be decoded, and decoded images waiting to be uploaded.
+ * When there are decoder threads, both lists and the entries' surfaces are
+ * guarded by `decode_lock`, and `decode_ready` is signaled when a job is
+ * queued or the threads should stop. Without them (under emscripten),
+ * asset_cache_pump() decodes the jobs itself.
+ */
+static list_t *decode_jobs = NULL;
+static list_t *decoded = NULL;
+static SDL_Thread **decoders = NULL;
+static size_t num_decoders = 0;
+static SDL_mutex *decode_lock = NULL;
+static SDL_cond *decode_ready = NULL;
+static bool decoders_stopping = false;
+static size_t num_pending = 0;
+
+static size_t hash_pointer(const void *pointer) {
+  // The finalizer of MurmurHash3, to spread out the aligned addresses
+  uint64_t hash = (uintptr_t)pointer;
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+static size_t hash_string(const char *string) {
+  // 64-bit FNV-1a
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (; *string != '\0'; string++) {
+    hash ^= (unsigned char)*string;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+static void table_init(table_t *table) {
+  table->slots = calloc(INITIAL_TABLE_CAPACITY, sizeof(slot_t));
+  assert(table->slots);
+  table->capacity = INITIAL_TABLE_CAPACITY;
+  table->size = 0;
+}
+
+/**
+ * Finds the slot holding the key, or the empty slot where it would go.
+ *
+ * @param by_contents true to compare keys as strings rather than pointers
+ */
+static slot_t *table_find(table_t *table, const void *key, size_t hash,
+                          bool by_contents) {
+  size_t mask = table->capacity - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    slot_t *slot = &table->slots[i];
+    if (slot->key == NULL || slot->key == key ||
+        (by_contents && strcmp(slot->key, key) == 0)) {
+      return slot;
+    }
+  }
+}
+
+static void table_put(table_t *table, const void *key, void *value,
+                      bool by_contents);
+
+static void table_grow(table_t *table, bool by_contents) {
+  slot_t *old_slots = table->slots;
+  size_t old_capacity = table->capacity;
+  table->capacity *= 2;
+  table->slots = calloc(table->capacity, sizeof(slot_t));
+  assert(table->slots);
+  table->size = 0;
+  for (size_t i = 0; i < old_capacity; i++) {
+    if (old_slots[i].key != NULL) {
+      table_put(table, old_slots[i].key, old_slots[i].value, by_contents);
+    }
+  }
+  free(old_slots);
+}
+
+static void table_put(table_t *table, const void *key, void *value,
+                      bool by_contents) {
+  if ((table->size + 1) * 4 > table->capacity * 3) {
+    table_grow(table, by_contents);
+  }
+  size_t hash = by_contents ? hash_string(key) : hash_pointer(key);
+  slot_t *slot = table_find(table, key, hash, by_contents);
+  if (slot->key == NULL) {
+    table->size++;
+  }
+  slot->key = key;
+  slot->value = value;
+}
+
+/**
+ * Gets the interned copy of a path, making one if needed.
+ */
+static const char *intern(const char *filepath) {
+  alias_t *alias =
+      &aliases[hash_pointer(filepath) & (ASSET_ALIAS_SLOTS - 1)];
+  if (alias->filepath == filepath) {
+    return alias->interned;
+  }
+
+  slot_t *slot = table_find(&paths, filepath, hash_string(filepath), true);
+  const char *interned = slot->key;
+  if (interned == NULL) {
+    char *copy = malloc(strlen(filepath) + 1);
+    assert(copy);
+    strcpy(copy, filepath);
+    table_put(&paths, copy, copy, true);
+    interned = copy;
+  }
+  *alias = (alias_t){.filepath = filepath, .interned = interned};
+  return interned;
+}
+
+/**
+ * Gets the entry for an image or font, adding an unloaded one if needed.
+ */
+static entry_t *asset_cache_lookup(asset_type_t ty, const char *filepath) {
+  assert(ty == ASSET_IMAGE || ty == ASSET_FONT);
+  assert(filepath);
+  table_t *table = ty == ASSET_IMAGE ? &textures : &fonts;
+
+  const char *interned = intern(filepath);
+  slot_t *slot = table_find(table, interned, hash_pointer(interned), false);
+  if (slot->key != NULL) {
+    return slot->value;
+  }
+
+  entry_t *entry = malloc(sizeof(entry_t));
+  assert(entry);
+  *entry = (entry_t){.type = ty, .filepath = interned};
+  table_put(table, interned, entry, false);
+  return entry;
+}
+
+static void lru_unlink(entry_t *entry) {
+  if (!entry->in_lru) {
+    return;
+  }
+  if (entry->lru_prev != NULL) {
+    entry->lru_prev->lru_next = entry->lru_next;
+  } else {
+    lru_head = entry->lru_next;
+  }
+  if (entry->lru_next != NULL) {
+    entry->lru_next->lru_prev = entry->lru_prev;
+  } else {
+    lru_tail = entry->lru_prev;
+  }
+  entry->lru_prev = NULL;
+  entry->lru_next = NULL;
+  entry->in_lru = false;
+}
+
+/**
+ * Moves a loaded, unreferenced image to the most recently used end of the
+ * LRU list.
+ */
+static void lru_touch(entry_t *entry) {
+  if (entry->type != ASSET_IMAGE || entry->status != ENTRY_LOADED ||
+      entry->refcount > 0 || entry->in_atlas) {
+    return;
+  }
+  lru_unlink(entry);
+  entry->lru_prev = lru_tail;
+  if (lru_tail != NULL) {
+    lru_tail->lru_next = entry;
+  } else {
+    lru_head = entry;
+  }
+  lru_tail = entry;
+  entry->in_lru = true;
+}
+
+static size_t estimate_texture_bytes(SDL_Texture *texture) {
+  Uint32 format;
+  int w, h;
+  if (texture == NULL || SDL_QueryTexture(texture, &format, NULL, &w, &h)) {
+    return 0;
+  }
+  size_t bytes_per_pixel = SDL_BYTESPERPIXEL(format);
+  if (bytes_per_pixel == 0) {
+    bytes_per_pixel = DEFAULT_BYTES_PER_PIXEL;
+  }
+  return (size_t)w * h * bytes_per_pixel;
+}
+
+/**
+ * Frees an entry's object, unless it is still being decoded or is part of
+ * the atlas. The entry's sprite stays valid but draws nothing.
+ */
+static void asset_cache_unload(entry_t *entry) {
+  if (entry->status != ENTRY_LOADED || entry->in_atlas) {
+    return;
   }
-  case ASSET_FONT: {
+  lru_unlink(entry);
+  if (entry->type == ASSET_IMAGE) {
+    if (entry->sprite.texture != NULL) {
+      SDL_DestroyTexture(entry->sprite.texture);
+    }
+    entry->sprite = (sprite_t){0};
+  } else if (entry->obj != NULL) {
     TTF_CloseFont(entry->obj);
-    break;
   }
-  case ASSET_BUTTON: {
-    asset_destroy(entry->obj);
-    break;
+  texture_bytes -= entry->bytes;
+  entry->bytes = 0;
+  entry->obj = NULL;
+  entry->status = ENTRY_UNLOADED;
+}
+
+/**
+ * Evicts least recently used images until the textures fit in the budget or
+ * every image left is referenced or atlased.
+ */
+static void enforce_budget(void) {
+  while (texture_bytes + atlas_get_bytes() > budget && lru_head != NULL) {
+    asset_cache_unload(lru_head);
   }
+}
+
+/**
+ * Makes a decoded image drawable: copies it into the atlas if it is small
+ * enough, otherwise uploads it to a texture of its own.
+ *
+ * @param surface the image, which this frees, or NULL if it couldn't be
+ * loaded
+ */
+static void asset_cache_set_image(entry_t *entry, SDL_Surface *surface) {
+  entry->status = ENTRY_LOADED;
+  if (atlas_add(surface, &entry->sprite)) {
+    entry->in_atlas = true;
+    SDL_FreeSurface(surface);
+  } else {
+    SDL_Rect src = {0};
+    if (surface != NULL) {
+      src = (SDL_Rect){.w = surface->w, .h = surface->h};
+    }
+    SDL_Texture *texture = surface_to_texture(surface);
+    entry->sprite = (sprite_t){.texture = texture, .src = src};
+    entry->bytes = estimate_texture_bytes(texture);
+    texture_bytes += entry->bytes;
   }
+  // The new image isn't in the LRU list yet, so it can't evict itself
+  enforce_budget();
+}
 
-  free(entry);
+static SDL_Texture *get_placeholder(void) {
+  if (placeholder == NULL) {
+    // A single transparent pixel, so nothing shows until the image is ready
+    placeholder = surface_to_texture(
+        SDL_CreateRGBSurfaceWithFormat(0, 1, 1, 32, SDL_PIXELFORMAT_RGBA32));
+  }
+  return placeholder;
 }
 
-void asset_cache_init() {
-  ASSET_CACHE =
-      list_init(INITIAL_CAPACITY, (free_func_t)asset_cache_free_entry);
+/**
+ * Gets an entry's object (its sprite, for images), loading it right away if
+ * it isn't loaded or being decoded already.
+ */
+static void *asset_cache_load(entry_t *entry) {
+  if (entry->status == ENTRY_UNLOADED) {
+    if (entry->type == ASSET_IMAGE) {
+      asset_cache_set_image(entry, image_to_surface(entry->filepath));
+    } else {
+      entry->obj = load_font(entry->filepath, FONT_SIZE);
+      entry->status = ENTRY_LOADED;
+    }
+  }
+  return entry->type == ASSET_IMAGE ? &entry->sprite : entry->obj;
+}
+
+/**
+ * A decoder thread: decodes queued images into surfaces until told to stop.
+ */
+static int asset_decoder(void *aux) {
+  SDL_LockMutex(decode_lock);
+  while (true) {
+    while (list_size(decode_jobs) == 0 && !decoders_stopping) {
+      SDL_CondWait(decode_ready, decode_lock);
+    }
+    if (decoders_stopping) {
+      break;
+    }
+    entry_t *entry = list_remove(decode_jobs, 0);
+    SDL_UnlockMutex(decode_lock);
+
+    // The path never changes, so it can be read without the lock
+    SDL_Surface *surface = image_to_surface(entry->filepath);
+
+    SDL_LockMutex(decode_lock);
+    entry->surface = surface;
+    list_add(decoded, entry);
+  }
+  SDL_UnlockMutex(decode_lock);
+  return 0;
+}
+
+static void start_decoders(void) {
+  decode_jobs = list_init(INITIAL_CAPACITY, NULL);
+  decoded = list_init(INITIAL_CAPACITY, NULL);
+  decoders_stopping = false;
+#ifndef __EMSCRIPTEN__
+  decode_lock = SDL_CreateMutex();
+  decode_ready = SDL_CreateCond();
+  if (decode_lock == NULL || decode_ready == NULL) {
+    return;
+  }
+  decoders = malloc(sizeof(SDL_Thread *) * ASSET_DECODE_THREADS);
+  assert(decoders);
+  for (size_t i = 0; i < ASSET_DECODE_THREADS; i++) {
+    SDL_Thread *thread = SDL_CreateThread(asset_decoder, "asset_decoder", NULL);
+    if (thread != NULL) {
+      decoders[num_decoders++] = thread;
+    }
+  }
+#endif
+}
+
+static void stop_decoders(void) {
+  if (num_decoders > 0) {
+    SDL_LockMutex(decode_lock);
+    decoders_stopping = true;
+    SDL_CondBroadcast(decode_ready);
+    SDL_UnlockMutex(decode_lock);
+    for (size_t i = 0; i < num_decoders; i++) {
+      SDL_WaitThread(decoders[i], NULL);
+    }
+  }
+  free(decoders);
+  decoders = NULL;
+  num_decoders = 0;
+  if (decode_ready != NULL) {
+    SDL_DestroyCond(decode_ready);
+    decode_ready = NULL;
+  }
+  if (decode_lock != NULL) {
+    SDL_DestroyMutex(decode_lock);
+    decode_lock = NULL;
+  }
+
+  // Drop the images that were never uploaded
+  for (size_t i = 0; i < list_size(decoded); i++) {
+    entry_t *entry = list_get(decoded, i);
+    SDL_FreeSurface(entry->surface);
+    entry->surface = NULL;
+  }
+  list_free(decode_jobs);
+  list_free(decoded);
+  decode_jobs = NULL;
+  decoded = NULL;
 }
 
-void asset_cache_destroy() { list_free(ASSET_CACHE); }
+/**
+ * Takes the next decoded image, decoding it first if there are no decoder
+ * threads.
+ *
+ * @return the image's entry, or NULL if none is ready
+ */
+static entry_t *take_decoded(void) {
+  if (num_decoders == 0) {
+    if (list_size(decode_jobs) == 0) {
+      return NULL;
+    }
+    entry_t *entry = list_remove(decode_jobs, 0);
+    entry->surface = image_to_surface(entry->filepath);
+    return entry;
+  }
+
+  entry_t *entry = NULL;
+  SDL_LockMutex(decode_lock);
+  if (list_size(decoded) > 0) {
+    entry = list_remove(decoded, 0);
+  }
+  SDL_UnlockMutex(decode_lock);
+  return entry;
+}
 
-void *check_present(const char *filepath) {
-  for (size_t i = 0; i < list_size(ASSET_CACHE); i++) {
-    entry_t *entry = list_get(ASSET_CACHE, i);
-    if (!entry->filepath || !filepath) {
+/**
+ * Unloads (and with `free_entries`, frees) every entry in a table.
+ *
+ * @param only_unreferenced true to skip entries that are still acquired
+ */
+static void table_unload(table_t *table, bool only_unreferenced,
+                         bool free_entries) {
+  for (size_t i = 0; i < table->capacity; i++) {
+    entry_t *entry = table->slots[i].value;
+    if (entry == NULL || (only_unreferenced && entry->refcount > 0)) {
       continue;
     }
-    if (strcmp(entry->filepath, filepath) == 0) {
-      return entry->obj;
+    asset_cache_unload(entry);
+    if (free_entries) {
+      free(entry);
     }
   }
-  return NULL;
 }
 
-void *asset_cache_obj_get_or_create(asset_type_t ty, const char *filepath) {
-  void *ret = check_present(filepath);
-  if (ret) {
-    return ret;
+void asset_cache_init() {
+  assert(buttons == NULL && "The asset cache is already initialized");
+  const char *budget_mb = getenv("ASSET_CACHE_BUDGET_MB");
+  if (budget_mb != NULL) {
+    budget = strtoull(budget_mb, NULL, 10) * ASSET_BYTES_PER_MB;
   }
+  // Open the archive before the decoder threads start reading from it
+  asset_archive_open(ASSET_ARCHIVE_PATH);
+  table_init(&paths);
+  table_init(&textures);
+  table_init(&fonts);
+  buttons = list_init(INITIAL_CAPACITY, (free_func_t)asset_destroy);
+  start_decoders();
+}
 
-  entry_t *entry = malloc(sizeof(entry_t));
-  assert(entry);
-  entry->type = ty;
-  entry->filepath = filepath;
+void asset_cache_destroy() {
+  // Destroying the buttons releases their images, so do it while the tables
+  // still exist
+  list_free(buttons);
+  buttons = NULL;
+  stop_decoders();
+  num_pending = 0;
 
-  if (ty == ASSET_IMAGE) {
-    entry->obj = image_to_texture(filepath);
-  } else if (ty == ASSET_FONT) {
-    entry->obj = TTF_OpenFont(filepath, FONT_SIZE);
+  table_unload(&textures, false, true);
+  table_unload(&fonts, false, true);
+  atlas_clear();
+  lru_head = NULL;
+  lru_tail = NULL;
+  texture_bytes = 0;
+  // The next init only sets the budget from the environment
+  budget = SIZE_MAX;
+  if (placeholder != NULL) {
+    SDL_DestroyTexture(placeholder);
+    placeholder = NULL;
+  }
+  for (size_t i = 0; i < paths.capacity; i++) {
+    free((char *)paths.slots[i].key);
   }
+  free(paths.slots);
+  memset(aliases, 0, sizeof(aliases));
+  free(textures.slots);
+  free(fonts.slots);
+}
 
-  list_add(ASSET_CACHE, entry);
+void *asset_cache_obj_get_or_create(asset_type_t ty, const char *filepath) {
+  entry_t *entry = asset_cache_lookup(ty, filepath);
+  void *obj = asset_cache_load(entry);
+  lru_touch(entry);
+  return obj;
+}
 
-  return entry->obj;
+void *asset_cache_acquire(asset_type_t ty, const char *filepath) {
+  entry_t *entry = asset_cache_lookup(ty, filepath);
+  entry->refcount++;
+  lru_unlink(entry);
+  return asset_cache_load(entry);
 }
 
-void asset_cache_register_button(asset_t *button) {
-  assert(asset_get_type(button) == ASSET_BUTTON);
+void asset_cache_release(asset_type_t ty, const char *filepath) {
+  if (buttons == NULL) {
+    // The cache is already gone, along with everything it held
+    return;
+  }
+  entry_t *entry = asset_cache_lookup(ty, filepath);
+  assert(entry->refcount > 0 && "Released an asset that wasn't acquired");
+  entry->refcount--;
+  if (entry->refcount == 0) {
+    lru_touch(entry);
+    enforce_budget();
+  }
+}
 
-  entry_t *button_entry = malloc(sizeof(entry_t));
-  assert(button_entry);
+void asset_cache_prefetch(const char *filepath) {
+  entry_t *entry = asset_cache_lookup(ASSET_IMAGE, filepath);
+  if (entry->status != ENTRY_UNLOADED) {
+    return;
+  }
+  entry->status = ENTRY_PENDING;
+  // Draws as nothing until the image is uploaded into the same sprite
+  entry->sprite =
+      (sprite_t){.texture = get_placeholder(), .src = {.w = 1, .h = 1}};
+  num_pending++;
+  if (num_decoders == 0) {
+    list_add(decode_jobs, entry);
+    return;
+  }
+  SDL_LockMutex(decode_lock);
+  list_add(decode_jobs, entry);
+  SDL_CondSignal(decode_ready);
+  SDL_UnlockMutex(decode_lock);
+}
 
-  button_entry->type = ASSET_BUTTON;
-  button_entry->filepath = NULL;
-  button_entry->obj = button;
+size_t asset_cache_pump(double time_budget) {
+  double start = timer_now();
+  size_t uploaded = 0;
+  do {
+    entry_t *entry = take_decoded();
+    if (entry == NULL) {
+      break;
+    }
+    SDL_Surface *surface = entry->surface;
+    entry->surface = NULL;
+    asset_cache_set_image(entry, surface);
+    lru_touch(entry);
+    num_pending--;
+    uploaded++;
+  } while (timer_now() - start < time_budget);
+  return uploaded;
+}
+
+size_t asset_cache_get_pending() { return num_pending; }
 
-  list_add(ASSET_CACHE, button_entry);
+bool asset_cache_is_placeholder(const sprite_t *sprite) {
+  return placeholder != NULL && sprite->texture == placeholder;
 }
 
-void asset_cache_handle_buttons(state_t *state, double x, double y) {
-  size_t size_of_asset_cache = list_size(ASSET_CACHE);
+void asset_cache_set_budget(size_t bytes) {
+  budget = bytes;
+  enforce_budget();
+}
 
-  for (size_t i = 0; i < size_of_asset_cache; ++i) {
-    entry_t *current_cache = list_get(ASSET_CACHE, i);
-    if (current_cache->type == ASSET_BUTTON) {
-      asset_on_button_click(current_cache->obj, state, x, y);
-    }
+size_t asset_cache_get_texture_bytes() {
+  return texture_bytes + atlas_get_bytes();
+}
+
+void asset_cache_purge() {
+  table_unload(&textures, true, false);
+  table_unload(&fonts, true, false);
+}
+
+void asset_cache_register_button(asset_t *button) {
+  assert(asset_get_type(button) == ASSET_BUTTON);
+  list_add(buttons, button);
+}
+
+void asset_cache_handle_buttons(state_t *state, double x, double y) {
+  for (size_t i = 0; i < list_size(buttons); ++i) {
+    asset_on_button_click(list_get(buttons, i), state, x, y);
   }
-}
\ No newline at end of file
+}
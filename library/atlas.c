@@ -0,0 +1,142 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "atlas.h"
+#include "list.h"
+
+// Left empty to the right of and below each image, so a scaled or rotated
+// sprite never samples its neighbor
+const int ATLAS_PADDING = 1;
+const size_t ATLAS_BYTES_PER_PIXEL = 4;
+const size_t ATLAS_INITIAL_SHELVES = 8;
+
+typedef struct shelf {
+  int y;
+  int height;
+  int used; // Width taken up from the left
+} shelf_t;
+
+typedef struct page {
+  SDL_Texture *texture;
+  list_t *shelves;
+  int top; // Height taken up by the shelves
+} page_t;
+
+/**
+ * The pages, in the order they were made, or NULL before the first one.
+ */
+static list_t *pages = NULL;
+
+static void page_free(page_t *page) {
+  SDL_DestroyTexture(page->texture);
+  list_free(page->shelves);
+  free(page);
+}
+
+static page_t *page_init(void) {
+  SDL_Texture *texture = sdl_create_texture(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+  if (texture == NULL) {
+    return NULL;
+  }
+  page_t *page = malloc(sizeof(page_t));
+  assert(page);
+  page->texture = texture;
+  page->shelves = list_init(ATLAS_INITIAL_SHELVES, free);
+  page->top = 0;
+  return page;
+}
+
+/**
+ * Finds room for an image on a page.
+ *
+ * @param rect set to where the image goes
+ * @return false if the page is full
+ */
+static bool page_pack(page_t *page, int w, int h, SDL_Rect *rect) {
+  int padded_w = w + ATLAS_PADDING;
+  int padded_h = h + ATLAS_PADDING;
+
+  // Use the shortest shelf the image fits on
+  shelf_t *best = NULL;
+  for (size_t i = 0; i < list_size(page->shelves); i++) {
+    shelf_t *shelf = list_get(page->shelves, i);
+    if (shelf->height >= padded_h &&
+        shelf->used + padded_w <= ATLAS_PAGE_SIZE &&
+        (best == NULL || shelf->height < best->height)) {
+      best = shelf;
+    }
+  }
+
+  // Start a new shelf instead if the best one would waste more than half its
+  // height, or if none fits
+  bool room_below = page->top + padded_h <= ATLAS_PAGE_SIZE;
+  if ((best == NULL || best->height > 2 * padded_h) && room_below) {
+    best = malloc(sizeof(shelf_t));
+    assert(best);
+    *best = (shelf_t){.y = page->top, .height = padded_h, .used = 0};
+    list_add(page->shelves, best);
+    page->top += padded_h;
+  }
+  if (best == NULL) {
+    return false;
+  }
+
+  *rect = (SDL_Rect){.x = best->used, .y = best->y, .w = w, .h = h};
+  best->used += padded_w;
+  return true;
+}
+
+bool atlas_add(SDL_Surface *surface, sprite_t *sprite) {
+  if (surface == NULL || surface->w > ATLAS_MAX_SPRITE_SIZE ||
+      surface->h > ATLAS_MAX_SPRITE_SIZE) {
+    return false;
+  }
+  // Pages hold RGBA32 pixels, which is what the raw image cache produces
+  SDL_Surface *converted = surface;
+  if (surface->format->format != SDL_PIXELFORMAT_RGBA32) {
+    converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (converted == NULL) {
+      return false;
+    }
+  }
+  if (pages == NULL) {
+    pages = list_init(1, (free_func_t)page_free);
+  }
+
+  page_t *page = NULL;
+  SDL_Rect rect;
+  for (size_t i = 0; i < list_size(pages) && page == NULL; i++) {
+    if (page_pack(list_get(pages, i), surface->w, surface->h, &rect)) {
+      page = list_get(pages, i);
+    }
+  }
+  if (page == NULL) {
+    page = page_init();
+    if (page != NULL) {
+      list_add(pages, page);
+      page_pack(page, surface->w, surface->h, &rect);
+    }
+  }
+
+  if (page != NULL) {
+    SDL_UpdateTexture(page->texture, &rect, converted->pixels,
+                      converted->pitch);
+    *sprite = (sprite_t){.texture = page->texture, .src = rect};
+  }
+  if (converted != surface) {
+    SDL_FreeSurface(converted);
+  }
+  return page != NULL;
+}
+
+void atlas_clear(void) {
+  if (pages != NULL) {
+    list_free(pages);
+    pages = NULL;
+  }
+}
+
+size_t atlas_get_bytes(void) {
+  size_t num_pages = pages != NULL ? list_size(pages) : 0;
+  return num_pages * ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * ATLAS_BYTES_PER_PIXEL;
+}
@@ -6,8 +6,9 @@
 
 struct body {
   polygon_t *poly;
+  vector_t prev_centroid;
 
-  double mass;
+  scalar_t mass;
 
   vector_t force;
   vector_t impulse;
@@ -17,17 +18,18 @@ struct body {
   free_func_t info_freer;
 };
 
-body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
+body_t *body_init(list_t *shape, scalar_t mass, rgb_color_t color) {
   return body_init_with_info(shape, mass, color, NULL, NULL);
 }
 
-body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
+body_t *body_init_with_info(list_t *shape, scalar_t mass, rgb_color_t color,
                             void *info, free_func_t info_freer) {
   body_t *body = malloc(sizeof(body_t));
   assert(body);
 
   body->mass = mass;
   body->poly = polygon_init(shape, VEC_ZERO, 0, color.r, color.g, color.b);
+  body->prev_centroid = body_get_centroid(body);
   body->force = VEC_ZERO;
   body->impulse = VEC_ZERO;
   body->removed = false;
@@ -95,21 +97,30 @@ void body_set_color(body_t *body, rgb_color_t *col) {
 
 void body_set_centroid(body_t *body, vector_t x) {
   polygon_set_center(body->poly, x);
+  // Teleports shouldn't be interpolated across
+  body->prev_centroid = x;
+}
+
+vector_t body_get_interpolated_centroid(body_t *body, double alpha) {
+  vector_t current = body_get_centroid(body);
+  return vec_add(body->prev_centroid,
+                 vec_multiply(alpha, vec_subtract(current, body->prev_centroid)));
 }
 
 void body_set_velocity(body_t *body, vector_t v) {
   polygon_set_velocity(body->poly, v);
 }
 
-double body_get_rotation(body_t *body) {
+scalar_t body_get_rotation(body_t *body) {
   return polygon_get_rotation(body->poly);
 }
 
-void body_set_rotation(body_t *body, double angle) {
+void body_set_rotation(body_t *body, scalar_t angle) {
   polygon_rotate(body->poly, angle, body_get_centroid(body));
 }
 
 void body_tick(body_t *body, double dt) {
+  body->prev_centroid = body_get_centroid(body);
   vector_t current_velocity = vec_add(
       body_get_velocity(body),
       vec_multiply(1 / body->mass,
@@ -123,7 +134,7 @@ void body_tick(body_t *body, double dt) {
   body->impulse = VEC_ZERO;
 }
 
-double body_get_mass(body_t *body) { return body->mass; }
+scalar_t body_get_mass(body_t *body) { return body->mass; }
 
 void body_add_force(body_t *body, vector_t force) {
   body->force = vec_add(body->force, force);
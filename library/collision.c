@@ -1,51 +1,28 @@
 #include "collision.h"
 #include "body.h"
+#include "vector_batch.h"
 
 #include <assert.h>
-#include <math.h>
+#include <tgmath.h>
 #include <stdlib.h>
 
 /**
- * Returns a list of vectors representing the edges of a shape.
+ * Computes the unit normal of every edge of a shape.
+ * Edge i runs between vertex i and vertex i + 1 (wrapping around), and its
+ * normal is the edge rotated a quarter turn.
  *
- * @param shape the list of vectors representing the vertices of a shape
- * @return a list of vectors representing the edges of the shape
+ * @param shape the vertices of a shape
+ * @param axes a batch of the same size as shape to store the normals in
  */
-static list_t *get_edges(list_t *shape) {
-  list_t *edges = list_init(list_size(shape), free);
-
-  for (size_t i = 0; i < list_size(shape); i++) {
-    vector_t *vec = malloc(sizeof(vector_t));
-    assert(vec);
-    *vec =
-        vec_subtract(*(vector_t *)list_get(shape, i % list_size(shape)),
-                     *(vector_t *)list_get(shape, (i + 1) % list_size(shape)));
-    list_add(edges, vec);
+static void get_edge_normals(vec_batch_t *shape, vec_batch_t *axes) {
+  size_t num_points = shape->size;
+  for (size_t i = 0; i < num_points; i++) {
+    size_t next = (i + 1) % num_points;
+    // Perpendicular to the edge
+    axes->x[i] = -(shape->y[i] - shape->y[next]);
+    axes->y[i] = shape->x[i] - shape->x[next];
   }
-
-  return edges;
-}
-
-/**
- * Returns a vector containing the maximum and minimum length projections given
- * a unit axis and shape.
- *
- * @param shape the list of vectors representing the vertices of a shape
- * @param unit_axis the unit axis to project eeach vertex on
- * @return a vector in the form (max, min) where `max` is the maximum projection
- * length and `min` is the minimum projection length.
- */
-static vector_t get_max_min_projections(list_t *shape, vector_t unit_axis) {
-  double max = vec_dot(unit_axis, *(vector_t *)list_get(shape, 0));
-  double min = max;
-
-  for (size_t i = 1; i < list_size(shape); i++) {
-    double projection = vec_dot(unit_axis, *(vector_t *)list_get(shape, i));
-    max = fmax(max, projection);
-    min = fmin(min, projection);
-  }
-
-  return (vector_t){.x = max, .y = min};
+  vec_batch_normalize(axes->x, axes->y, num_points);
 }
 
 /**
@@ -60,31 +37,34 @@ static vector_t get_max_min_projections(list_t *shape, vector_t unit_axis) {
  * @param radius the threshold radius for the overlap occuring
  * @return whether the shapes are colliding
  */
-static collision_info_t compare_collision_radius(list_t *shape1, list_t *shape2,
-                                          double *min_overlap, size_t radius) {
-  list_t *edges1 = get_edges(shape1);
+static collision_info_t compare_collision_radius(vec_batch_t *shape1,
+                                                 vec_batch_t *shape2,
+                                                 scalar_t *min_overlap,
+                                                 size_t radius) {
+  vec_batch_t axes;
+  vec_batch_init(&axes, shape1->size);
+  get_edge_normals(shape1, &axes);
 
   vector_t ret_axis = VEC_ZERO;
 
-  for (size_t i = 0; i < list_size(edges1); i++) {
-    vector_t edge = *(vector_t *)list_get(edges1, i);
-    vector_t axis = {.x = -edge.y, .y = edge.x}; // Perpendicular to the edge
-
-    vector_t unit_axis =
-        vec_multiply(1 / vec_get_length(axis), axis); // Unit vector of the axis
+  for (size_t i = 0; i < axes.size; i++) {
+    vector_t unit_axis = {.x = axes.x[i], .y = axes.y[i]};
 
-    vector_t projections1 = get_max_min_projections(shape1, unit_axis);
-    vector_t projections2 = get_max_min_projections(shape2, unit_axis);
+    // Each projection is a vector in the form (max, min)
+    vector_t projections1 = vec_batch_project_max_min(shape1->x, shape1->y,
+                                                      shape1->size, unit_axis);
+    vector_t projections2 = vec_batch_project_max_min(shape2->x, shape2->y,
+                                                      shape2->size, unit_axis);
 
     // If the projections don't overlap, then shape1 and shape2 don't collide
     if (projections1.x + radius < projections2.y || 
         projections2.x + radius < projections1.y) {
-      list_free(edges1);
+      vec_batch_release(&axes);
       return (collision_info_t){false, VEC_ZERO};
     }
 
-    double overlap = fmin(fabs(projections2.x - projections1.y),
-                          fabs(projections1.x - projections2.y));
+    scalar_t overlap = fmin(fabs(projections2.x - projections1.y),
+                            fabs(projections1.x - projections2.y));
 
     // Override overlap and axis if needed
     if (overlap < *min_overlap) {
@@ -93,24 +73,28 @@ static collision_info_t compare_collision_radius(list_t *shape1, list_t *shape2,
     }
   }
 
-  list_free(edges1);
+  vec_batch_release(&axes);
   return (collision_info_t){true, ret_axis};
 }
 
 collision_info_t find_collision_melee(body_t *body1, body_t *body2, size_t radius) {
-  list_t *shape1 = body_get_shape(body1);
-  list_t *shape2 = body_get_shape(body2);
+  // Read the vertices straight out of the polygons; body_get_shape() would
+  // allocate a copy of every vertex just for us to read it
+  vec_batch_t shape1;
+  vec_batch_t shape2;
+  vec_batch_from_list(&shape1, polygon_get_points(body_get_polygon(body1)));
+  vec_batch_from_list(&shape2, polygon_get_points(body_get_polygon(body2)));
 
-  double c1_overlap = __DBL_MAX__;
-  double c2_overlap = __DBL_MAX__;
+  scalar_t c1_overlap = SCALAR_MAX;
+  scalar_t c2_overlap = SCALAR_MAX;
 
   collision_info_t collision1 = 
-  compare_collision_radius(shape1, shape2, &c1_overlap, radius);
+  compare_collision_radius(&shape1, &shape2, &c1_overlap, radius);
   collision_info_t collision2 = 
-  compare_collision_radius(shape2, shape1, &c2_overlap, radius);
+  compare_collision_radius(&shape2, &shape1, &c2_overlap, radius);
 
-  list_free(shape1);
-  list_free(shape2);
+  vec_batch_release(&shape1);
+  vec_batch_release(&shape2);
 
   if (!collision1.collided) {
     return collision1;
@@ -1,6 +1,7 @@
 #include "math.h"
 #include "sdl_wrapper.h"
 #include "state.h"
+#include "timer.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -11,6 +12,9 @@
 
 state_t *state;
 
+// Native builds sleep between frames instead of spinning a core
+const double NATIVE_MAX_FPS = 120;
+
 void loop() {
   // If needed, generate a pointer to our initial state
   if (!state) {
@@ -40,6 +44,7 @@ int main() {
 #else
   while (1) {
     loop();
+    timer_limit_frame(NATIVE_MAX_FPS);
   }
 #endif
 }
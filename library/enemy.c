@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include "enemy.h"
+#include "vector_batch.h"
 
 const rgb_color_t ENEMY_COLOR = (rgb_color_t){0.2, 0.2, 0.3};
 const vector_t ENEMY_SIZE = (vector_t) {35, 35};
@@ -85,14 +86,46 @@ void enemy_move_towards_player(enemy_t *enemy, body_t *player, list_t *projectil
         direction_to_player = VEC_ZERO;
     }
 
-    vector_t dodge_direction = VEC_ZERO;
+    // Gather the offsets to every player projectile so their distances can be
+    // computed in a single batch. Even with only a few projectiles this beats
+    // measuring them one at a time (see enemy_dodge/<n> in bin/micro).
+    size_t num_player_projectiles = 0;
+    for (size_t i = 0; i < list_size(projectiles); i++) {
+        if (projectile_get_type(list_get(projectiles, i)) == PROJECTILE_PLAYER) {
+            num_player_projectiles++;
+        }
+    }
+
+    vec_batch_t offsets;
+    vec_batch_init(&offsets, num_player_projectiles);
+    size_t k = 0;
     for (size_t i = 0; i < list_size(projectiles); i++) {
         projectile_t *projectile = list_get(projectiles, i);
         if (projectile_get_type(projectile) == PROJECTILE_PLAYER) {
             vector_t projectile_pos = 
             body_get_centroid(projectile_get_hitbox(projectile));
-            vector_t to_projectile = vec_subtract(projectile_pos, enemy_pos);
-            double distance_to_projectile = vec_get_length(to_projectile);
+            offsets.x[k] = projectile_pos.x - enemy_pos.x;
+            offsets.y[k] = projectile_pos.y - enemy_pos.y;
+            k++;
+        }
+    }
+
+    scalar_t inline_distances[VEC_BATCH_INLINE];
+    scalar_t *distances = inline_distances;
+    if (num_player_projectiles > VEC_BATCH_INLINE) {
+        distances = malloc(num_player_projectiles * sizeof(scalar_t));
+        assert(distances);
+    }
+    vec_batch_length(offsets.x, offsets.y, num_player_projectiles, distances);
+
+    vector_t dodge_direction = VEC_ZERO;
+    k = 0;
+    for (size_t i = 0; i < list_size(projectiles); i++) {
+        projectile_t *projectile = list_get(projectiles, i);
+        if (projectile_get_type(projectile) == PROJECTILE_PLAYER) {
+            vector_t to_projectile = {.x = offsets.x[k], .y = offsets.y[k]};
+            double distance_to_projectile = distances[k];
+            k++;
 
             // First check if the projectile is within dodge radius
             if (distance_to_projectile < dodge_radius) {
@@ -118,6 +151,11 @@ void enemy_move_towards_player(enemy_t *enemy, body_t *player, list_t *projectil
         }
     }
 
+    if (distances != inline_distances) {
+        free(distances);
+    }
+    vec_batch_release(&offsets);
+
     // Combine dodge and movement velocities
     vector_t combined_direction = vec_add(direction_to_player, dodge_direction);
     body_set_velocity(enemy_get_hitbox(enemy), combined_direction);
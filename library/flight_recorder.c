@@ -0,0 +1,176 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "flight_recorder.h"
+#include "log.h"
+#include "profiler.h"
+#include "timer.h"
+
+#define FLIGHT_HISTORY 300
+#define FLIGHT_MAX_INPUTS 8
+
+const double FLIGHT_DEFAULT_BUDGET = 0.025;
+const double FLIGHT_MS_PER_S = 1e3;
+// Stop dumping after this many files so a badly stuttering session can't
+// fill the disk
+const size_t FLIGHT_MAX_DUMPS = 16;
+const size_t FLIGHT_PATH_SIZE = 32;
+
+typedef struct flight_input {
+  const char *type;
+  int code;
+  double x;
+  double y;
+} flight_input_t;
+
+typedef struct flight_frame {
+  size_t index;
+  double start;    // From timer_now(), in seconds
+  double interval; // Time since the previous frame started
+  double work;     // Time from flight_recorder_frame_begin() to _end()
+  double stages[PROFILE_STAGE_COUNT];
+  size_t bodies;
+  size_t force_creators;
+  size_t projectiles;
+  size_t enemies;
+  flight_input_t inputs[FLIGHT_MAX_INPUTS];
+  size_t num_inputs;
+  size_t dropped_inputs;
+} flight_frame_t;
+
+/**
+ * The most recent frames. frames[frames_recorded % FLIGHT_HISTORY] is the
+ * frame being recorded.
+ */
+static flight_frame_t frames[FLIGHT_HISTORY];
+static size_t frames_recorded = 0;
+/**
+ * The frame budget in seconds, or a negative number before it is read from
+ * the environment.
+ */
+static double budget = -1;
+static size_t dumps_written = 0;
+/**
+ * Set after a dump so the frame that pays for writing it isn't reported too.
+ */
+static bool skip_next_check = false;
+
+/**
+ * Returns the frame being recorded.
+ */
+static flight_frame_t *current_frame(void) {
+  return &frames[frames_recorded % FLIGHT_HISTORY];
+}
+
+static double get_budget(void) {
+  if (budget < 0) {
+    const char *budget_ms = getenv("FLIGHT_BUDGET_MS");
+    budget = budget_ms != NULL ? atof(budget_ms) / FLIGHT_MS_PER_S
+                               : FLIGHT_DEFAULT_BUDGET;
+  }
+  return budget;
+}
+
+void flight_recorder_set_budget(double seconds) { budget = seconds; }
+
+void flight_recorder_input(const char *type, int code, double x, double y) {
+  flight_frame_t *frame = current_frame();
+  if (frame->num_inputs == FLIGHT_MAX_INPUTS) {
+    frame->dropped_inputs++;
+    return;
+  }
+  frame->inputs[frame->num_inputs++] =
+      (flight_input_t){.type = type, .code = code, .x = x, .y = y};
+}
+
+void flight_recorder_frame_begin(double interval) {
+  flight_frame_t *frame = current_frame();
+  frame->index = frames_recorded;
+  frame->start = timer_now();
+  frame->interval = interval;
+}
+
+/**
+ * Writes one frame as a JSON object.
+ */
+static void write_frame(FILE *file, flight_frame_t *frame) {
+  fprintf(file,
+          "  {\"frame\": %zu, \"start_ms\": %.3f, \"interval_ms\": %.3f, "
+          "\"work_ms\": %.3f,\n   \"stages_ms\": {",
+          frame->index, frame->start * FLIGHT_MS_PER_S,
+          frame->interval * FLIGHT_MS_PER_S, frame->work * FLIGHT_MS_PER_S);
+  for (size_t stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+    fprintf(file, "%s\"%s\": %.3f", stage > 0 ? ", " : "",
+            profiler_stage_name(stage),
+            frame->stages[stage] * FLIGHT_MS_PER_S);
+  }
+  fprintf(file,
+          "},\n   \"bodies\": %zu, \"force_creators\": %zu, "
+          "\"projectiles\": %zu, \"enemies\": %zu,\n   \"inputs\": [",
+          frame->bodies, frame->force_creators, frame->projectiles,
+          frame->enemies);
+  for (size_t i = 0; i < frame->num_inputs; i++) {
+    flight_input_t *input = &frame->inputs[i];
+    fprintf(file, "%s{\"type\": \"%s\", \"code\": %d, \"x\": %.0f, \"y\": %.0f}",
+            i > 0 ? ", " : "", input->type, input->code, input->x, input->y);
+  }
+  fprintf(file, "], \"dropped_inputs\": %zu}", frame->dropped_inputs);
+}
+
+/**
+ * Writes every frame in the ring buffer, oldest first, to the next
+ * flight_<n>.json file.
+ */
+static void dump(flight_frame_t *trigger) {
+  char path[FLIGHT_PATH_SIZE];
+  snprintf(path, sizeof(path), "flight_%zu.json", dumps_written);
+  dumps_written++;
+
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    return;
+  }
+  fprintf(file, "{\"budget_ms\": %.3f, \"trigger_frame\": %zu,\n",
+          get_budget() * FLIGHT_MS_PER_S, trigger->index);
+  fprintf(file, " \"frames\": [\n");
+  size_t count = frames_recorded < FLIGHT_HISTORY ? frames_recorded + 1
+                                                  : FLIGHT_HISTORY;
+  for (size_t i = 0; i < count; i++) {
+    size_t index = frames_recorded + 1 - count + i;
+    write_frame(file, &frames[index % FLIGHT_HISTORY]);
+    fprintf(file, "%s\n", i + 1 < count ? "," : "");
+  }
+  fprintf(file, " ]}\n");
+  fclose(file);
+  LOG_WARN("frame %zu took %.1f ms, wrote %s", trigger->index,
+          trigger->interval * FLIGHT_MS_PER_S, path);
+}
+
+void flight_recorder_frame_end(size_t bodies, size_t force_creators,
+                               size_t projectiles, size_t enemies) {
+  flight_frame_t *frame = current_frame();
+  frame->work = timer_now() - frame->start;
+  for (size_t stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+    frame->stages[stage] = profiler_get_last(stage);
+  }
+  frame->bodies = bodies;
+  frame->force_creators = force_creators;
+  frame->projectiles = projectiles;
+  frame->enemies = enemies;
+
+  bool over_budget = frame->interval > get_budget() ||
+                     frame->work > get_budget();
+  if (over_budget && !skip_next_check && dumps_written < FLIGHT_MAX_DUMPS) {
+    dump(frame);
+    skip_next_check = true;
+  } else {
+    skip_next_check = false;
+  }
+
+  // Start the next frame; input that arrives before it begins belongs to it
+  frames_recorded++;
+  flight_frame_t *next = current_frame();
+  next->num_inputs = 0;
+  next->dropped_inputs = 0;
+}
@@ -1,26 +1,26 @@
 #include "forces.h"
 
 #include <assert.h>
-#include <math.h>
+#include <tgmath.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-const double MIN_DIST = 5;
+const scalar_t MIN_DIST = 5;
 
 typedef struct body_aux {
-  double force_const;
+  scalar_t force_const;
   list_t *bodies;
 } body_aux_t;
 
 typedef struct collision_aux {
-  double force_const;
+  scalar_t force_const;
   list_t *bodies;
   collision_handler_t handler;
   bool collided;
   void *aux; // aux (if allocated in memory) should be free'd by the caller
 } collision_aux_t;
 
-body_aux_t *body_aux_init(double force_const, list_t *bodies) {
+body_aux_t *body_aux_init(scalar_t force_const, list_t *bodies) {
   body_aux_t *aux = malloc(sizeof(body_aux_t));
   assert(aux);
 
@@ -30,7 +30,7 @@ body_aux_t *body_aux_init(double force_const, list_t *bodies) {
   return aux;
 }
 
-collision_aux_t *collision_aux_init(double force_const, list_t *bodies,
+collision_aux_t *collision_aux_init(scalar_t force_const, list_t *bodies,
                                     collision_handler_t handler, bool collided,
                                     void *aux) {
   collision_aux_t *collision_aux = malloc(sizeof(collision_aux_t));
@@ -82,7 +82,7 @@ static void newtonian_gravity(void *info) {
   vector_t unit_disp =
       vec_multiply(1 / sqrt(vec_dot(displacement, displacement)), displacement);
 
-  double distance = sqrt(vec_dot(displacement, displacement));
+  scalar_t distance = sqrt(vec_dot(displacement, displacement));
 
   if (distance > MIN_DIST) {
     vector_t grav_force = vec_multiply(
@@ -96,7 +96,7 @@ static void newtonian_gravity(void *info) {
   }
 }
 
-void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
+void create_newtonian_gravity(scene_t *scene, scalar_t G, body_t *body1,
                               body_t *body2) {
   list_t *bodies = list_init(2, NULL);
   list_t *aux_bodies = list_init(2, NULL);
@@ -119,7 +119,7 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
 static void spring_force(void *info) {
   body_aux_t *aux = info;
 
-  double k = aux->force_const;
+  scalar_t k = aux->force_const;
   body_t *body1 = list_get(aux->bodies, 0);
   body_t *body2 = list_get(aux->bodies, 1);
 
@@ -132,7 +132,7 @@ static void spring_force(void *info) {
   body_add_force(body2, vec_negate(spring_force));
 }
 
-void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
+void create_spring(scene_t *scene, scalar_t k, body_t *body1, body_t *body2) {
   list_t *bodies = list_init(2, NULL);
   list_add(bodies, body1);
   list_add(bodies, body2);
@@ -159,7 +159,7 @@ static void drag_force(void *info) {
   body_add_force(list_get(aux->bodies, 0), cons_force);
 }
 
-void create_drag(scene_t *scene, double gamma, body_t *body) {
+void create_drag(scene_t *scene, scalar_t gamma, body_t *body) {
   list_t *bodies = list_init(1, NULL);
   list_t *aux_bodies = list_init(1, NULL);
   list_add(bodies, body);
@@ -199,7 +199,7 @@ static void collision_force_creator(void *collision_aux) {
 
 void create_collision(scene_t *scene, body_t *body1, body_t *body2,
                       collision_handler_t handler, void *aux,
-                      double force_const) {
+                      scalar_t force_const) {
   list_t *bodies = list_init(2, NULL);
   list_add(bodies, body1);
   list_add(bodies, body2);
@@ -219,7 +219,7 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2,
  * The collision handler for destructive collisions.
  */
 static void destructive_collision(body_t *body1, body_t *body2, vector_t axis,
-                                  void *aux, double force_const) {
+                                  void *aux, scalar_t force_const) {
   body_remove(body1);
   body_remove(body2);
 }
@@ -230,19 +230,21 @@ void create_destructive_collision(scene_t *scene, body_t *body1,
 }
 
 void physics_collision_handler(body_t *body1, body_t *body2, vector_t axis,
-                               void *aux, double force_const) {
-  double u1 = vec_dot(axis, body_get_velocity(body1));
-  double u2 = vec_dot(axis, body_get_velocity(body2));
+                               void *aux, scalar_t force_const) {
+  scalar_t u1 = vec_dot(axis, body_get_velocity(body1));
+  scalar_t u2 = vec_dot(axis, body_get_velocity(body2));
 
-  double reduced_mass;
+  scalar_t reduced_mass;
 
-  double mass1 = body_get_mass(body1);
-  double mass2 = body_get_mass(body2);
+  scalar_t mass1 = body_get_mass(body1);
+  scalar_t mass2 = body_get_mass(body2);
 
-  // Edge case for if mass of a body is infinity
-  if (mass1 == INFINITY) {
+  // Edge case for if mass of a body is infinity. Masses are scalar_t, so in
+  // single precision this is a float INFINITY; isinf() is type-generic and
+  // catches it in either build.
+  if (isinf(mass1)) {
     reduced_mass = mass2;
-  } else if (mass2 == INFINITY) {
+  } else if (isinf(mass2)) {
     reduced_mass = mass1;
   } else {
     reduced_mass = (mass1 * mass2) / (mass1 + mass2);
@@ -256,7 +258,7 @@ void physics_collision_handler(body_t *body1, body_t *body2, vector_t axis,
 }
 
 void create_physics_collision(scene_t *scene, body_t *body1, body_t *body2,
-                              double elasticity) {
+                              scalar_t elasticity) {
   create_collision(scene, body1, body2, physics_collision_handler, NULL,
                    elasticity);
 }
@@ -0,0 +1,62 @@
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hud.h"
+
+typedef struct hud_text {
+  TTF_Font *font;
+  SDL_Rect rect; // Sized to the texture once there is one
+  SDL_Color color;
+  char text[HUD_TEXT_SIZE];
+  SDL_Texture *texture; // NULL if the text is empty or can't be rendered
+} hud_text_t;
+
+hud_text_t *hud_text_init(TTF_Font *font, SDL_Rect position, SDL_Color color) {
+  hud_text_t *text = malloc(sizeof(hud_text_t));
+  assert(text);
+  text->font = font;
+  text->rect = position;
+  text->color = color;
+  text->text[0] = '\0';
+  text->texture = NULL;
+  return text;
+}
+
+void hud_text_set(hud_text_t *text, const char *format, ...) {
+  char formatted[HUD_TEXT_SIZE];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(formatted, sizeof(formatted), format, args);
+  va_end(args);
+  if (strcmp(formatted, text->text) == 0) {
+    return;
+  }
+
+  strcpy(text->text, formatted);
+  if (text->texture != NULL) {
+    SDL_DestroyTexture(text->texture);
+  }
+  text->texture = text_to_texture(text->text, text->font, text->color);
+  if (text->texture != NULL) {
+    SDL_QueryTexture(text->texture, NULL, NULL, &text->rect.w, &text->rect.h);
+  }
+}
+
+void hud_text_render(hud_text_t *text) {
+  if (text->texture != NULL) {
+    sdl_render_image(text->texture, text->rect);
+  }
+}
+
+void hud_text_free(hud_text_t *text) {
+  if (text == NULL) {
+    return;
+  }
+  if (text->texture != NULL) {
+    SDL_DestroyTexture(text->texture);
+  }
+  free(text);
+}
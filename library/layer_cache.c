@@ -0,0 +1,80 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "layer_cache.h"
+#include "sdl_wrapper.h"
+
+typedef struct layer_cache {
+  SDL_Texture *texture; // NULL if there is none yet or it can't be made
+  size_t generation;    // sdl_get_render_target_generation() when made
+  void *key;            // The key the texture was last drawn with
+  size_t key_size;
+  bool valid; // Whether the texture holds the contents for `key`
+} layer_cache_t;
+
+layer_cache_t *layer_cache_init(void) {
+  layer_cache_t *cache = malloc(sizeof(layer_cache_t));
+  assert(cache);
+  *cache = (layer_cache_t){.texture = NULL, .key = NULL, .valid = false};
+  return cache;
+}
+
+bool layer_cache_begin(layer_cache_t *cache, const void *key, size_t key_size) {
+  size_t generation = sdl_get_render_target_generation();
+  if (cache->texture != NULL && cache->generation != generation) {
+    SDL_DestroyTexture(cache->texture);
+    cache->texture = NULL;
+  }
+  if (cache->texture == NULL) {
+    cache->texture = sdl_create_render_target();
+    cache->generation = generation;
+    cache->valid = false;
+    if (cache->texture == NULL) {
+      // Draw straight to the window instead
+      return true;
+    }
+  }
+
+  if (cache->valid && cache->key_size == key_size &&
+      memcmp(cache->key, key, key_size) == 0) {
+    return false;
+  }
+  if (cache->key_size != key_size) {
+    cache->key = realloc(cache->key, key_size);
+    assert(cache->key || key_size == 0);
+    cache->key_size = key_size;
+  }
+  memcpy(cache->key, key, key_size);
+  cache->valid = true;
+  sdl_begin_render_target(cache->texture);
+  return true;
+}
+
+void layer_cache_end(layer_cache_t *cache) {
+  if (cache->texture != NULL) {
+    sdl_end_render_target();
+  }
+}
+
+void layer_cache_draw(layer_cache_t *cache) {
+  if (cache->texture == NULL || !cache->valid) {
+    return;
+  }
+  SDL_Rect rect = {.x = 0, .y = 0};
+  SDL_QueryTexture(cache->texture, NULL, NULL, &rect.w, &rect.h);
+  sdl_render_image(cache->texture, rect);
+}
+
+void layer_cache_invalidate(layer_cache_t *cache) { cache->valid = false; }
+
+void layer_cache_free(layer_cache_t *cache) {
+  if (cache == NULL) {
+    return;
+  }
+  if (cache->texture != NULL) {
+    SDL_DestroyTexture(cache->texture);
+  }
+  free(cache->key);
+  free(cache);
+}
@@ -0,0 +1,129 @@
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+
+#include "log.h"
+
+// Must be a power of two so the ring indices can wrap around freely
+#define LOG_CAPACITY 256
+
+// The drain thread wakes up at least this often (in ms), in case it missed
+// the wake-up for a message
+const Uint32 LOG_DRAIN_INTERVAL = 50;
+const char *LOG_LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+typedef struct log_entry {
+  int level;
+  char message[LOG_MESSAGE_SIZE];
+} log_entry_t;
+
+/**
+ * The queued messages are entries[tail % LOG_CAPACITY] up to
+ * entries[head % LOG_CAPACITY]. Only the game thread writes head and only the
+ * drainer writes tail; each publishes its side with a release store.
+ */
+static log_entry_t entries[LOG_CAPACITY];
+static atomic_size_t head = 0;
+static atomic_size_t tail = 0;
+static atomic_size_t dropped = 0;
+
+/**
+ * The drain thread, or NULL if messages are printed by log_end_frame().
+ * wake is posted when a message goes into an empty ring.
+ */
+static SDL_Thread *drainer = NULL;
+static SDL_sem *wake = NULL;
+static atomic_bool stopping = false;
+static bool initialized = false;
+
+/**
+ * Prints and removes every queued message.
+ * Must only be called by one thread at a time.
+ */
+static void log_drain(void) {
+  size_t read = atomic_load_explicit(&tail, memory_order_relaxed);
+  size_t written = atomic_load_explicit(&head, memory_order_acquire);
+  while (read != written) {
+    for (; read != written; read++) {
+      log_entry_t *entry = &entries[read % LOG_CAPACITY];
+      FILE *out = entry->level >= LOG_LEVEL_WARN ? stderr : stdout;
+      fprintf(out, "%s: %s\n", LOG_LEVEL_NAMES[entry->level], entry->message);
+    }
+    atomic_store_explicit(&tail, read, memory_order_release);
+    written = atomic_load_explicit(&head, memory_order_acquire);
+  }
+
+  size_t lost = atomic_exchange_explicit(&dropped, 0, memory_order_relaxed);
+  if (lost > 0) {
+    fprintf(stderr, "WARN: %zu log messages dropped\n", lost);
+  }
+  fflush(stdout);
+}
+
+static int log_drainer(void *aux) {
+  while (!atomic_load(&stopping)) {
+    SDL_SemWaitTimeout(wake, LOG_DRAIN_INTERVAL);
+    log_drain();
+  }
+  return 0;
+}
+
+void log_init(void) {
+  if (initialized) {
+    return;
+  }
+  initialized = true;
+  atexit(log_shutdown);
+
+#ifndef __EMSCRIPTEN__
+  wake = SDL_CreateSemaphore(0);
+  if (wake != NULL) {
+    atomic_store(&stopping, false);
+    drainer = SDL_CreateThread(log_drainer, "log", NULL);
+  }
+#endif
+}
+
+void log_write(int level, const char *format, ...) {
+  size_t written = atomic_load_explicit(&head, memory_order_relaxed);
+  size_t read = atomic_load_explicit(&tail, memory_order_acquire);
+  if (written - read == LOG_CAPACITY) {
+    atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+    return;
+  }
+
+  log_entry_t *entry = &entries[written % LOG_CAPACITY];
+  entry->level = level;
+  va_list args;
+  va_start(args, format);
+  vsnprintf(entry->message, LOG_MESSAGE_SIZE, format, args);
+  va_end(args);
+  atomic_store_explicit(&head, written + 1, memory_order_release);
+
+  if (written == read && drainer != NULL) {
+    SDL_SemPost(wake);
+  }
+}
+
+void log_end_frame(void) {
+  if (drainer == NULL) {
+    log_drain();
+  }
+}
+
+void log_shutdown(void) {
+  if (drainer != NULL) {
+    atomic_store(&stopping, true);
+    SDL_SemPost(wake);
+    SDL_WaitThread(drainer, NULL);
+    drainer = NULL;
+  }
+  if (wake != NULL) {
+    SDL_DestroySemaphore(wake);
+    wake = NULL;
+  }
+  log_drain();
+}
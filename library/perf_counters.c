@@ -0,0 +1,262 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "perf_counters.h"
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#define PERF_EVENT_OPEN_AVAILABLE
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+typedef enum {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_L1D_MISSES,
+  PERF_LLC_MISSES,
+  PERF_BRANCH_MISSES,
+  PERF_COUNTER_COUNT
+} perf_counter_t;
+
+const char *PERF_COUNTER_NAMES[PERF_COUNTER_COUNT] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+const double PERF_MS_PER_S = 1e3;
+const double PERF_PER_KILO = 1e3;
+
+typedef struct perf_stage {
+  size_t calls;
+  double seconds;
+  uint64_t counts[PERF_COUNTER_COUNT];
+  uint64_t start[PERF_COUNTER_COUNT]; // Values read when the stage began
+} perf_stage_t;
+
+static perf_stage_t stages[PROFILE_STAGE_COUNT];
+
+/**
+ * The file descriptor of the group leader (the cycle counter), or -1 if the
+ * counters aren't open.
+ */
+static int group_fd = -1;
+/**
+ * Where each counter's value is in a read of the whole group, or -1 if the
+ * counter couldn't be opened.
+ */
+static int slots[PERF_COUNTER_COUNT];
+static size_t num_open = 0;
+static const char *unavailable_reason = "perf_counters_init() wasn't called";
+static int open_error = 0;
+static bool exit_report_registered = false;
+
+#ifdef PERF_EVENT_OPEN_AVAILABLE
+/**
+ * The layout of a read() from the group leader with the read_format below.
+ */
+typedef struct perf_group_read {
+  uint64_t nr;
+  uint64_t time_enabled;
+  uint64_t time_running;
+  uint64_t values[PERF_COUNTER_COUNT];
+} perf_group_read_t;
+
+static int perf_open(uint32_t type, uint64_t config, int group) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  // The whole group is enabled at once through the leader
+  attr.disabled = group == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static uint64_t cache_miss_config(uint64_t cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+static void perf_open_all(void) {
+  const uint32_t types[PERF_COUNTER_COUNT] = {
+      PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+      PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE};
+  const uint64_t configs[PERF_COUNTER_COUNT] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      cache_miss_config(PERF_COUNT_HW_CACHE_L1D), PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES};
+
+  group_fd = perf_open(types[PERF_CYCLES], configs[PERF_CYCLES], -1);
+  if (group_fd < 0) {
+    open_error = errno;
+    unavailable_reason = errno == EACCES || errno == EPERM
+                             ? "perf_event_open isn't permitted (check "
+                               "/proc/sys/kernel/perf_event_paranoid)"
+                             : "perf_event_open failed";
+    return;
+  }
+  slots[PERF_CYCLES] = num_open++;
+
+  // The other counters are optional; a CPU or VM may not have all of them
+  for (perf_counter_t counter = PERF_CYCLES + 1; counter < PERF_COUNTER_COUNT;
+       counter++) {
+    if (perf_open(types[counter], configs[counter], group_fd) >= 0) {
+      slots[counter] = num_open++;
+    }
+  }
+  ioctl(group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  unavailable_reason = NULL;
+}
+
+/**
+ * Reads every open counter at once.
+ *
+ * @param values where to store the counters' values, indexed by counter
+ * @param coverage if not NULL, set to the fraction of the time the counters
+ *   were enabled that they were actually counting
+ * @return true if the read succeeded
+ */
+static bool perf_read(uint64_t values[PERF_COUNTER_COUNT], double *coverage) {
+  perf_group_read_t group;
+  if (read(group_fd, &group, sizeof(group)) < 0) {
+    return false;
+  }
+  for (perf_counter_t counter = 0; counter < PERF_COUNTER_COUNT; counter++) {
+    values[counter] = slots[counter] >= 0 ? group.values[slots[counter]] : 0;
+  }
+  if (coverage != NULL) {
+    *coverage = group.time_enabled > 0
+                    ? (double)group.time_running / group.time_enabled
+                    : 1;
+  }
+  return true;
+}
+#endif
+
+static void perf_counters_report_at_exit(void);
+
+void perf_counters_init(void) {
+  memset(stages, 0, sizeof(stages));
+  if (!exit_report_registered) {
+    for (perf_counter_t counter = 0; counter < PERF_COUNTER_COUNT; counter++) {
+      slots[counter] = -1;
+    }
+#ifdef PERF_EVENT_OPEN_AVAILABLE
+    perf_open_all();
+#else
+    unavailable_reason = "perf_event_open is only available on Linux";
+#endif
+    atexit(perf_counters_report_at_exit);
+    exit_report_registered = true;
+  }
+}
+
+void perf_counters_stage_begin(profile_stage_t stage) {
+#ifdef PERF_EVENT_OPEN_AVAILABLE
+  if (group_fd >= 0) {
+    perf_read(stages[stage].start, NULL);
+  }
+#endif
+}
+
+void perf_counters_stage_end(profile_stage_t stage, double seconds) {
+  perf_stage_t *totals = &stages[stage];
+  totals->calls++;
+  totals->seconds += seconds;
+#ifdef PERF_EVENT_OPEN_AVAILABLE
+  uint64_t now[PERF_COUNTER_COUNT];
+  if (group_fd >= 0 && perf_read(now, NULL)) {
+    for (perf_counter_t counter = 0; counter < PERF_COUNTER_COUNT; counter++) {
+      totals->counts[counter] += now[counter] - totals->start[counter];
+    }
+  }
+#endif
+}
+
+/**
+ * Gets a stage's count of a counter per thousand instructions, or a negative
+ * number if either counter is missing.
+ */
+static double per_kilo_instruction(perf_stage_t *stage,
+                                   perf_counter_t counter) {
+  if (slots[counter] < 0 || stage->counts[PERF_INSTRUCTIONS] == 0) {
+    return -1;
+  }
+  return stage->counts[counter] * PERF_PER_KILO /
+         stage->counts[PERF_INSTRUCTIONS];
+}
+
+static void print_ratio(FILE *out, double ratio) {
+  if (ratio < 0) {
+    fprintf(out, " %8s", "-");
+  } else {
+    fprintf(out, " %8.2f", ratio);
+  }
+}
+
+void perf_counters_report(FILE *out) {
+  fprintf(out, "# perf counters, per call except wall ms\n");
+  if (unavailable_reason != NULL) {
+    fprintf(out, "# no hardware counters: %s%s%s; wall time only\n",
+            unavailable_reason, open_error != 0 ? ": " : "",
+            open_error != 0 ? strerror(open_error) : "");
+  }
+#ifdef PERF_EVENT_OPEN_AVAILABLE
+  uint64_t unused[PERF_COUNTER_COUNT];
+  double coverage;
+  if (group_fd >= 0 && perf_read(unused, &coverage) && coverage < 1) {
+    // Another program was using the counters, so some events went uncounted
+    fprintf(out, "# counters were multiplexed and only ran %.0f%% of the time\n",
+            coverage * 100);
+  }
+#endif
+
+  fprintf(out, "%-14s %8s %10s %10s", "stage", "calls", "wall ms", "us/call");
+  if (group_fd >= 0) {
+    for (perf_counter_t counter = 0; counter < PERF_COUNTER_COUNT; counter++) {
+      fprintf(out, " %14s", PERF_COUNTER_NAMES[counter]);
+    }
+    fprintf(out, " %8s %8s %8s %8s", "ipc", "l1d/ki", "llc/ki", "br/ki");
+  }
+  fprintf(out, "\n");
+
+  for (profile_stage_t stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+    perf_stage_t *totals = &stages[stage];
+    if (totals->calls == 0) {
+      continue;
+    }
+    fprintf(out, "%-14s %8zu %10.2f %10.2f", profiler_stage_name(stage),
+            totals->calls, totals->seconds * PERF_MS_PER_S,
+            totals->seconds * PERF_MS_PER_S * PERF_MS_PER_S / totals->calls);
+    if (group_fd < 0) {
+      fprintf(out, "\n");
+      continue;
+    }
+
+    for (perf_counter_t counter = 0; counter < PERF_COUNTER_COUNT; counter++) {
+      if (slots[counter] < 0) {
+        fprintf(out, " %14s", "-");
+      } else {
+        fprintf(out, " %14.0f",
+                (double)totals->counts[counter] / totals->calls);
+      }
+    }
+    bool has_ipc = slots[PERF_INSTRUCTIONS] >= 0 && totals->counts[PERF_CYCLES];
+    print_ratio(out, has_ipc ? (double)totals->counts[PERF_INSTRUCTIONS] /
+                                   totals->counts[PERF_CYCLES]
+                             : -1);
+    print_ratio(out, per_kilo_instruction(totals, PERF_L1D_MISSES));
+    print_ratio(out, per_kilo_instruction(totals, PERF_LLC_MISSES));
+    print_ratio(out, per_kilo_instruction(totals, PERF_BRANCH_MISSES));
+    fprintf(out, "\n");
+  }
+}
+
+static void perf_counters_report_at_exit(void) { perf_counters_report(stderr); }
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "log.h"
 #include "player.h"
 
 const size_t PLAYER_HEIGHT = 35; 
@@ -85,7 +86,7 @@ void player_lvl_up(player_t *player) {
     player->level++;
     player->level_scale += LVL_SCALE_INCREASE;
 
-    printf("You have leveled up! You are now level %zu.\n", player->level);
+    LOG_INFO("You have leveled up! You are now level %zu.", player->level);
 
     player->health = PLAYER_HEALTH;
     player->damage += DAMAGE_SCALING_FACTOR;
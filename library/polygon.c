@@ -1,21 +1,21 @@
 #include "polygon.h"
 #include "color.h"
 #include "list.h"
-#include "math.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <tgmath.h>
 
 typedef struct polygon {
   list_t *points;
   vector_t velocity;
   vector_t centroid;
-  double rotation_speed;
-  double rotation;
+  scalar_t rotation_speed;
+  scalar_t rotation;
   rgb_color_t *color;
 } polygon_t;
 
 polygon_t *polygon_init(list_t *points, vector_t initial_velocity,
-                        double rotation_speed, double red, double green,
+                        scalar_t rotation_speed, double red, double green,
                         double blue) {
   polygon_t *polygon = malloc(sizeof(polygon_t));
   assert(polygon);
@@ -51,8 +51,8 @@ vector_t *polygon_get_velocity(polygon_t *polygon) {
   return &(polygon->velocity);
 }
 
-double polygon_area(polygon_t *polygon) {
-  double area = 0.0;
+scalar_t polygon_area(polygon_t *polygon) {
+  scalar_t area = 0.0;
   size_t num_points = list_size(polygon->points);
 
   for (size_t i = 0; i < num_points; ++i) {
@@ -78,8 +78,9 @@ vector_t polygon_centroid(polygon_t *polygon) {
                                        vec_add(*current_point, *next_point)));
   }
 
-  centroid.x /= 6 * polygon_area(polygon);
-  centroid.y /= 6 * polygon_area(polygon);
+  scalar_t area = polygon_area(polygon);
+  centroid.x /= 6 * area;
+  centroid.y /= 6 * area;
 
   return centroid;
 }
@@ -93,14 +94,19 @@ void polygon_translate(polygon_t *polygon, vector_t translation) {
   polygon->centroid = vec_add(polygon->centroid, translation);
 }
 
-void polygon_rotate(polygon_t *polygon, double angle, vector_t point) {
-  polygon_translate(polygon, vec_multiply(-1, point));
-  size_t num_points = list_size(polygon->points);
-  for (size_t i = 0; i < num_points; ++i) {
-    vector_t *current_point = list_get(polygon->points, i);
-    *current_point = vec_rotate(*current_point, angle);
+void polygon_rotate(polygon_t *polygon, scalar_t angle, vector_t point) {
+  // Rotating in place is faster than a vec_batch_rotate() at every polygon
+  // size bin/micro measures, since the batch has to copy the points out of
+  // the list and back; cos and sin are still only evaluated once per polygon
+  scalar_t cos_angle = cos(angle);
+  scalar_t sin_angle = sin(angle);
+  for (size_t i = 0; i < list_size(polygon->points); i++) {
+    vector_t *vertex = list_get(polygon->points, i);
+    scalar_t x = vertex->x - point.x;
+    scalar_t y = vertex->y - point.y;
+    vertex->x = point.x + x * cos_angle - y * sin_angle;
+    vertex->y = point.y + x * sin_angle + y * cos_angle;
   }
-  polygon_translate(polygon, point);
   polygon->rotation += angle;
 }
 
@@ -120,8 +126,8 @@ vector_t polygon_get_center(polygon_t *polygon) {
   return polygon_centroid(polygon);
 }
 
-void polygon_set_rotation(polygon_t *polygon, double rot) {
+void polygon_set_rotation(polygon_t *polygon, scalar_t rot) {
   polygon_rotate(polygon, rot - polygon->rotation, polygon->centroid);
 }
 
-double polygon_get_rotation(polygon_t *polygon) { return polygon->rotation; }
+scalar_t polygon_get_rotation(polygon_t *polygon) { return polygon->rotation; }
@@ -0,0 +1,111 @@
+#include <string.h>
+
+#include "perf_counters.h"
+#include "profiler.h"
+#include "trace.h"
+
+#define PROFILE_HISTORY 120
+
+const char *PROFILE_STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+    "scene_forces",  "scene_tick", "clear_enemies",
+    "render_assets", "render_bars", "sdl_show"};
+
+/**
+ * Time spent in each stage during the frame in progress.
+ */
+static double current[PROFILE_STAGE_COUNT];
+/**
+ * When the frame in progress started, from timer_now().
+ */
+static double frame_start = 0;
+/**
+ * Stage and total times of the most recent frames, used as ring buffers.
+ */
+static double history[PROFILE_HISTORY][PROFILE_STAGE_COUNT];
+static double frame_history[PROFILE_HISTORY];
+/**
+ * The total number of frames finished; the history holds the last
+ * PROFILE_HISTORY of them.
+ */
+static size_t frames_profiled = 0;
+
+double profiler_stage_begin(profile_stage_t stage) {
+  double now = timer_now();
+#if defined(TRACE) && !defined(__EMSCRIPTEN__)
+  trace_span_at('B', PROFILE_STAGE_NAMES[stage], now);
+#endif
+#ifdef PERF_COUNTERS
+  perf_counters_stage_begin(stage);
+#endif
+  return now;
+}
+
+void profiler_stage_end(profile_stage_t stage, double start) {
+#ifdef PERF_COUNTERS
+  // Read the counters first so they don't include the rest of this function
+  perf_counters_stage_end(stage, timer_now() - start);
+#endif
+  double now = timer_now();
+  profiler_record(stage, now - start);
+#if defined(TRACE) && !defined(__EMSCRIPTEN__)
+  trace_span_at('E', PROFILE_STAGE_NAMES[stage], now);
+#endif
+}
+
+void profiler_record(profile_stage_t stage, double seconds) {
+  current[stage] += seconds;
+}
+
+void profiler_frame_begin(void) {
+  memset(current, 0, sizeof(current));
+  frame_start = timer_now();
+}
+
+void profiler_frame_end(void) {
+  size_t slot = frames_profiled % PROFILE_HISTORY;
+  memcpy(history[slot], current, sizeof(current));
+  frame_history[slot] = timer_now() - frame_start;
+  frames_profiled++;
+}
+
+const char *profiler_stage_name(profile_stage_t stage) {
+  return PROFILE_STAGE_NAMES[stage];
+}
+
+/**
+ * Returns the number of frames in the history.
+ */
+static size_t frames_in_history(void) {
+  return frames_profiled < PROFILE_HISTORY ? frames_profiled : PROFILE_HISTORY;
+}
+
+double profiler_get_last(profile_stage_t stage) {
+  if (frames_profiled == 0) {
+    return 0;
+  }
+  return history[(frames_profiled - 1) % PROFILE_HISTORY][stage];
+}
+
+double profiler_get_average(profile_stage_t stage) {
+  size_t frames = frames_in_history();
+  if (frames == 0) {
+    return 0;
+  }
+  double total = 0;
+  for (size_t i = 0; i < frames; i++) {
+    total += history[i][stage];
+  }
+  return total / frames;
+}
+
+double profiler_get_average_frame(void) {
+  size_t frames = frames_in_history();
+  if (frames == 0) {
+    return 0;
+  }
+  double total = 0;
+  for (size_t i = 0; i < frames; i++) {
+    total += frame_history[i];
+  }
+  return total / frames;
+}
@@ -0,0 +1,71 @@
+#include <stdio.h>
+
+#include "profiler_overlay.h"
+#include "sdl_wrapper.h"
+#include "timer.h"
+
+const SDL_Color PROFILE_STAGE_COLORS[PROFILE_STAGE_COUNT] = {
+    {230, 80, 60, 255},  {240, 170, 40, 255}, {120, 200, 70, 255},
+    {60, 170, 220, 255}, {150, 100, 230, 255}, {200, 200, 200, 255}};
+
+// The overlay's bar spans one 60 fps frame; longer frames are clipped
+const double PROFILE_BAR_BUDGET = 1.0 / 60;
+const SDL_Rect PROFILE_BAR = {.x = 10, .y = 45, .w = 240, .h = 10};
+const SDL_Color PROFILE_BAR_BACKGROUND = {40, 40, 40, 255};
+const SDL_Color PROFILE_TEXT_COLOR = {255, 255, 255, 255};
+const int PROFILE_SWATCH_SIZE = 10;
+const int PROFILE_TEXT_MARGIN = 6;
+const double PROFILE_MS_PER_S = 1e3;
+const size_t PROFILE_TEXT_SIZE = 64;
+
+void profiler_render_overlay(TTF_Font *font) {
+  // Stacked bar of the last frame, one segment per stage
+  sdl_draw_rect(PROFILE_BAR, PROFILE_BAR_BACKGROUND);
+  int x = PROFILE_BAR.x;
+  int bar_end = PROFILE_BAR.x + PROFILE_BAR.w;
+  for (size_t stage = 0; stage < PROFILE_STAGE_COUNT && x < bar_end; stage++) {
+    int width =
+        (int)(profiler_get_last(stage) / PROFILE_BAR_BUDGET * PROFILE_BAR.w);
+    if (width > bar_end - x) {
+      width = bar_end - x;
+    }
+    SDL_Rect segment = {.x = x, .y = PROFILE_BAR.y, .w = width,
+                        .h = PROFILE_BAR.h};
+    sdl_draw_rect(segment, PROFILE_STAGE_COLORS[stage]);
+    x += width;
+  }
+
+  // Rolling averages, with the color of each stage's segment
+  int row_height = sdl_font_height(font);
+  int y = PROFILE_BAR.y + PROFILE_BAR.h + PROFILE_TEXT_MARGIN;
+  char text[PROFILE_TEXT_SIZE];
+  for (size_t stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+    SDL_Rect swatch = {.x = PROFILE_BAR.x,
+                       .y = y + (row_height - PROFILE_SWATCH_SIZE) / 2,
+                       .w = PROFILE_SWATCH_SIZE,
+                       .h = PROFILE_SWATCH_SIZE};
+    sdl_draw_rect(swatch, PROFILE_STAGE_COLORS[stage]);
+
+    snprintf(text, sizeof(text), "%s %.2f ms", profiler_stage_name(stage),
+             profiler_get_average(stage) * PROFILE_MS_PER_S);
+    SDL_Rect text_rect = {.x = swatch.x + swatch.w + PROFILE_TEXT_MARGIN,
+                          .y = y};
+    sdl_render_text_color(text, font, text_rect, PROFILE_STAGE_COLORS[stage]);
+    y += row_height;
+  }
+
+  snprintf(text, sizeof(text), "frame %.2f ms",
+           profiler_get_average_frame() * PROFILE_MS_PER_S);
+  SDL_Rect text_rect = {.x = PROFILE_BAR.x, .y = y};
+  sdl_render_text_color(text, font, text_rect, PROFILE_TEXT_COLOR);
+  y += row_height;
+
+  // Time between ticks, including the frame limiter's sleep and vsync, so a
+  // hitch shows up in the max even when the average frame looks fine
+  frame_stats_t stats = timer_get_frame_stats();
+  snprintf(text, sizeof(text), "tick %.2f ms (%.2f-%.2f)",
+           stats.mean * PROFILE_MS_PER_S, stats.min * PROFILE_MS_PER_S,
+           stats.max * PROFILE_MS_PER_S);
+  text_rect.y = y;
+  sdl_render_text_color(text, font, text_rect, PROFILE_TEXT_COLOR);
+}
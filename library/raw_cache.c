@@ -0,0 +1,174 @@
+#include <SDL2/SDL_image.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "asset_archive.h"
+#include "raw_cache.h"
+
+const char *RAW_CACHE_SUFFIX = ".raw";
+const char *RAW_CACHE_TEMP_SUFFIX = ".raw.tmp";
+const size_t RAW_CACHE_BYTES_PER_PIXEL = 4;
+
+static uint64_t hash_bytes(const uint8_t *bytes, size_t size) {
+  // 64-bit FNV-1a, as for the archive's paths
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+static bool raw_cache_enabled(void) {
+#ifdef __EMSCRIPTEN__
+  return false;
+#else
+  const char *setting = getenv("RAW_CACHE");
+  return setting == NULL || strcmp(setting, "0") != 0;
+#endif
+}
+
+/**
+ * Reads a whole file into a new buffer.
+ *
+ * @return the buffer, which the caller must free, or NULL on failure
+ */
+static uint8_t *read_file(const char *path, size_t *size) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+  uint8_t *bytes = NULL;
+  long length;
+  if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) > 0 &&
+      fseek(file, 0, SEEK_SET) == 0) {
+    bytes = malloc(length);
+    if (bytes != NULL && fread(bytes, 1, length, file) != (size_t)length) {
+      free(bytes);
+      bytes = NULL;
+    }
+    *size = length;
+  }
+  fclose(file);
+  return bytes;
+}
+
+/**
+ * Reads a .raw file, if it was made from a source with the given hash.
+ *
+ * @return the pixels as a new surface, or NULL if the file is missing, stale
+ * or damaged
+ */
+static SDL_Surface *read_raw(const char *raw_path, uint64_t source_hash,
+                             uint64_t source_size) {
+  FILE *file = fopen(raw_path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+  raw_cache_header_t header;
+  SDL_Surface *surface = NULL;
+  if (fread(&header, sizeof(header), 1, file) == 1 &&
+      memcmp(header.magic, RAW_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+      header.version == RAW_CACHE_VERSION &&
+      header.source_hash == source_hash &&
+      header.source_size == source_size && header.width > 0 &&
+      header.height > 0) {
+    surface = SDL_CreateRGBSurfaceWithFormat(0, header.width, header.height, 32,
+                                             SDL_PIXELFORMAT_RGBA32);
+  }
+  size_t row_size =
+      surface != NULL ? (size_t)surface->w * RAW_CACHE_BYTES_PER_PIXEL : 0;
+  for (int y = 0; surface != NULL && y < surface->h; y++) {
+    uint8_t *row = (uint8_t *)surface->pixels + (size_t)y * surface->pitch;
+    if (fread(row, 1, row_size, file) != row_size) {
+      // Cut short, e.g. by a crash while it was being written
+      SDL_FreeSurface(surface);
+      surface = NULL;
+    }
+  }
+  fclose(file);
+  return surface;
+}
+
+/**
+ * Writes an RGBA32 surface to a .raw file. Writes to a temporary file first,
+ * so a reader never sees a half-written one.
+ */
+static void write_raw(const char *raw_path, const char *temp_path,
+                      SDL_Surface *surface, uint64_t source_hash,
+                      uint64_t source_size) {
+  FILE *file = fopen(temp_path, "wb");
+  if (file == NULL) {
+    return;
+  }
+  raw_cache_header_t header = {.version = RAW_CACHE_VERSION,
+                               .width = surface->w,
+                               .height = surface->h,
+                               .source_hash = source_hash,
+                               .source_size = source_size};
+  memcpy(header.magic, RAW_CACHE_MAGIC, sizeof(header.magic));
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+  size_t row_size = (size_t)surface->w * RAW_CACHE_BYTES_PER_PIXEL;
+  for (int y = 0; written && y < surface->h; y++) {
+    uint8_t *row = (uint8_t *)surface->pixels + (size_t)y * surface->pitch;
+    written = fwrite(row, 1, row_size, file) == row_size;
+  }
+  if (fclose(file) != 0 || !written || rename(temp_path, raw_path) != 0) {
+    remove(temp_path);
+  }
+}
+
+/**
+ * Decodes an image from its bytes into an RGBA32 surface.
+ */
+static SDL_Surface *decode(const uint8_t *bytes, size_t size) {
+  SDL_Surface *decoded = IMG_Load_RW(SDL_RWFromConstMem(bytes, size), 1);
+  if (decoded == NULL || decoded->format->format == SDL_PIXELFORMAT_RGBA32) {
+    return decoded;
+  }
+  SDL_Surface *converted =
+      SDL_ConvertSurfaceFormat(decoded, SDL_PIXELFORMAT_RGBA32, 0);
+  SDL_FreeSurface(decoded);
+  return converted;
+}
+
+SDL_Surface *raw_cache_load(const char *path) {
+  if (!raw_cache_enabled()) {
+    return IMG_Load_RW(asset_archive_rw(path), 1);
+  }
+
+  // The source is needed for its hash anyway, so it is read once and decoded
+  // from memory if the .raw file turns out to be stale
+  size_t size = 0;
+  uint8_t *file_bytes = NULL;
+  const uint8_t *bytes = asset_archive_find(path, &size);
+  if (bytes == NULL) {
+    bytes = file_bytes = read_file(path, &size);
+    if (bytes == NULL) {
+      return NULL;
+    }
+  }
+  uint64_t hash = hash_bytes(bytes, size);
+
+  size_t path_size = strlen(path);
+  char *raw_path = malloc(path_size + strlen(RAW_CACHE_SUFFIX) + 1);
+  char *temp_path = malloc(path_size + strlen(RAW_CACHE_TEMP_SUFFIX) + 1);
+  assert(raw_path && temp_path);
+  sprintf(raw_path, "%s%s", path, RAW_CACHE_SUFFIX);
+  sprintf(temp_path, "%s%s", path, RAW_CACHE_TEMP_SUFFIX);
+
+  SDL_Surface *surface = read_raw(raw_path, hash, size);
+  if (surface == NULL) {
+    surface = decode(bytes, size);
+    if (surface != NULL) {
+      write_raw(raw_path, temp_path, surface, hash, size);
+    }
+  }
+  free(raw_path);
+  free(temp_path);
+  free(file_bytes);
+  return surface;
+}
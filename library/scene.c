@@ -3,6 +3,8 @@
 #include <stdlib.h>
 
 #include "forces.h"
+#include "profiler.h"
+#include "trace.h"
 #include "scene.h"
 
 typedef struct scene {
@@ -16,14 +18,17 @@ const size_t INIT_SIZE = 10;
 const size_t MAX_FORCES = 3;
 
 void scene_forces(scene_t *scene) {
+  PROFILE_BEGIN(PROFILE_SCENE_FORCES);
   // Call all the force creators in the scene
   for (size_t i = 0; i < list_size(scene->force_creator_list); i++) {
     force_activator_t *force_activator = list_get(scene->force_creator_list, i);
     force_activator->forcer(force_activator->aux);
   }
+  PROFILE_END(PROFILE_SCENE_FORCES);
 }
 
 void scene_tick(scene_t *scene, double dt) {
+  PROFILE_BEGIN(PROFILE_SCENE_TICK);
   for (ssize_t i = scene->num_bodies - 1; i >= 0; i--) {
     body_t *body = scene_get_body(scene, i);
     if (body_is_removed(body)) {
@@ -49,6 +54,7 @@ void scene_tick(scene_t *scene, double dt) {
       body_tick(body, dt);
     }
   }
+  PROFILE_END(PROFILE_SCENE_TICK);
 }
 
 void scene_add_force_creator(scene_t *scene, force_creator_t force_creator,
@@ -66,7 +72,17 @@ scene_type_t scene_get_type(scene_t *current_scene) {
     return current_scene->type;
 }
 
+#ifdef TRACE
+// Names of the scene transitions in the trace, indexed by scene_type_t
+static const char *SCENE_TRACE_NAMES[] = {
+    "scene_menu", "scene_game", "scene_boss", "scene_game_over_win",
+    "scene_game_over_loss"};
+#endif
+
 void scene_set_type(scene_t *current_scene, scene_type_t new_scene_type) {
+    if (current_scene->type != new_scene_type) {
+        TRACE_INSTANT(SCENE_TRACE_NAMES[new_scene_type]);
+    }
     current_scene->type = new_scene_type;
 }
 
@@ -89,6 +105,10 @@ void scene_free(scene_t *scene) {
   free(scene);
 }
 
+size_t scene_force_creators(scene_t *scene) {
+  return list_size(scene->force_creator_list);
+}
+
 size_t scene_bodies(scene_t *scene) { return scene->num_bodies; }
 
 body_t *scene_get_body(scene_t *scene, size_t index) {
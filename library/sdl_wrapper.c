@@ -4,11 +4,17 @@
 #include <assert.h>
 #include <float.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
 
+#include "asset_archive.h"
 #include "asset_cache.h"
+#include "flight_recorder.h"
+#include "profiler.h"
+#include "raw_cache.h"
 #include "sdl_wrapper.h"
+#include "timer.h"
 
 const size_t BLUE_VALUE = 255;
 SDL_Color WHITE = {255, 255, 255};
@@ -22,6 +28,11 @@ const char *MUSIC_PATH = "assets/music.ogg";
 const size_t FREQUENCY = 22050;
 const size_t CHANNELS = 2;
 const size_t CHUNK_SIZE = 4096;
+const size_t RENDER_QUEUE_INITIAL_SPRITES = 256;
+// Texture slots fit in the low byte of a sort key
+#define RENDER_QUEUE_TEXTURES 256
+#define RENDER_QUEUE_RADIX 256
+const double DEGREES_PER_RADIAN = 180 / M_PI;
 
 /**
  * The coordinate at the center of the screen.
@@ -57,13 +68,57 @@ mouse_handler_t mouse_handler = NULL;
  */
 uint32_t key_start_timestamp;
 /**
- * The value of clock() when time_since_last_tick() was last called.
- * Initially 0.
+ * The value of timer_now() when time_since_last_tick() was last called.
+ * Negative until the first call.
  */
-clock_t last_clock = 0;
+double last_tick_time = -1;
+/**
+ * Whether something happened that needs the screen to be drawn again,
+ * e.g. input or the window being exposed or resized.
+ * Starts true so the first frame is always drawn.
+ */
+bool redraw_requested = true;
+/**
+ * Bumped whenever textures made with sdl_create_render_target() lose their
+ * contents or stop matching the window's size.
+ */
+static size_t render_target_generation = 0;
+
+/**
+ * A sprite in the render queue, as the 4 corners of its quad.
+ */
+typedef struct queued_sprite {
+  uint16_t key; // The layer in the high byte, the texture's slot in the low
+  SDL_Vertex vertices[4];
+} queued_sprite_t;
+
+/**
+ * Sprites drawn since the last flush, in the order they were drawn.
+ * Each distinct texture among them gets the next slot in queue_textures,
+ * along with its size for turning source rects into texture coordinates.
+ */
+static queued_sprite_t *queue = NULL;
+static size_t queue_size = 0;
+static size_t queue_capacity = 0;
+static SDL_Texture *queue_textures[RENDER_QUEUE_TEXTURES];
+static int queue_texture_widths[RENDER_QUEUE_TEXTURES];
+static int queue_texture_heights[RENDER_QUEUE_TEXTURES];
+static size_t num_queue_textures = 0;
+/**
+ * Scratch space for flushing the queue: the sprites' indices in sorted
+ * order, and their vertices gathered in that order with 6 indices per quad.
+ */
+static uint32_t *queue_order = NULL;
+static uint32_t *queue_scratch = NULL;
+static SDL_Vertex *batch_vertices = NULL;
+static int *batch_indices = NULL;
 
 /** Computes the center of the window in pixel coordinates */
 vector_t get_window_center(void) {
+  if (window == NULL) {
+    // Headless builds lay the scene out as if the window had its initial size
+    return (vector_t){.x = WINDOW_WIDTH / 2.0, .y = WINDOW_HEIGHT / 2.0};
+  }
   int *width = malloc(sizeof(*width)), *height = malloc(sizeof(*height));
   assert(width != NULL);
   assert(height != NULL);
@@ -145,6 +200,7 @@ SDL_Rect sdl_get_bounding_box(body_t *body) {
       max_y = point->y;
     }
   }
+  list_free(shape);
 
   vector_t window_center = get_window_center();
   vector_t top_left =
@@ -161,12 +217,26 @@ SDL_Rect sdl_get_bounding_box(body_t *body) {
   return bounding_box;
 }
 
+SDL_Rect sdl_get_interpolated_bounding_box(body_t *body, double alpha) {
+  SDL_Rect bounding_box = sdl_get_bounding_box(body);
+
+  vector_t window_center = get_window_center();
+  vector_t current =
+      get_window_position(body_get_centroid(body), window_center);
+  vector_t shown = get_window_position(
+      body_get_interpolated_centroid(body, alpha), window_center);
+  bounding_box.x += shown.x - current.x;
+  bounding_box.y += shown.y - current.y;
+
+  return bounding_box;
+}
+
 void sdl_start_music() {
   if (Mix_OpenAudio(FREQUENCY, MIX_DEFAULT_FORMAT, CHANNELS, CHUNK_SIZE) == -1) {
     return;
   }
 
-  music = Mix_LoadMUS(MUSIC_PATH);
+  music = Mix_LoadMUS_RW(asset_archive_rw(MUSIC_PATH), 1);
 
   if (music == NULL) {
     return;
@@ -189,6 +259,11 @@ void sdl_init(vector_t min, vector_t max) {
 
   center = vec_multiply(0.5, vec_add(min, max));
   max_diff = vec_subtract(max, center);
+#ifdef HEADLESS
+  // No window, renderer, fonts or audio: window and renderer stay NULL,
+  // which turns every drawing function into a no-op
+  SDL_Init(SDL_INIT_TIMER);
+#else
   SDL_Init(SDL_INIT_EVERYTHING);
   window = SDL_CreateWindow(WINDOW_TITLE, SDL_WINDOWPOS_CENTERED,
                             SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT,
@@ -197,6 +272,7 @@ void sdl_init(vector_t min, vector_t max) {
   TTF_Init();
 
   sdl_start_music();
+#endif
 }
 
 bool sdl_is_done(void *state) {
@@ -208,8 +284,23 @@ bool sdl_is_done(void *state) {
         free(event);
         return true;
       }
+      case SDL_WINDOWEVENT: {
+        // Covers expose, resize, restore, etc.; the window contents may be gone
+        redraw_requested = true;
+        if (event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+          render_target_generation++;
+        }
+        break;
+      }
+      case SDL_RENDER_TARGETS_RESET:
+      case SDL_RENDER_DEVICE_RESET: {
+        redraw_requested = true;
+        render_target_generation++;
+        break;
+      }
       case SDL_KEYDOWN:
       case SDL_KEYUP: {
+        redraw_requested = true;
         // Skip the keypress if no handler is configured
         // or an unrecognized key was pressed
         if (key_handler == NULL)
@@ -224,11 +315,15 @@ bool sdl_is_done(void *state) {
         }
         key_event_type_t type =
             event->type == SDL_KEYDOWN ? KEY_PRESSED : KEY_RELEASED;
+        FLIGHT_INPUT(type == KEY_PRESSED ? "key_down" : "key_up", key, 0, 0);
         double held_time = (timestamp - key_start_timestamp) / MS_PER_S;
         key_handler(key, type, held_time, state);
         break;
       }
       case SDL_MOUSEBUTTONDOWN: {
+        redraw_requested = true;
+        FLIGHT_INPUT("mouse_down", event->button.button, event->button.x,
+                     event->button.y);
         if (mouse_handler == NULL) {
           break;
         }
@@ -250,6 +345,12 @@ bool sdl_is_done(void *state) {
 }
 
 void sdl_clear(void) {
+  if (renderer == NULL) {
+    return;
+  }
+  // Anything still queued would be cleared away anyway
+  queue_size = 0;
+  num_queue_textures = 0;
   SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
   SDL_RenderClear(renderer);
 }
@@ -259,6 +360,9 @@ void sdl_draw_polygon(polygon_t *poly, rgb_color_t color) {
   // Check parameters
   size_t n = list_size(points);
   assert(n >= 3);
+  if (renderer == NULL) {
+    return;
+  }
 
   vector_t window_center = get_window_center();
 
@@ -275,6 +379,7 @@ void sdl_draw_polygon(polygon_t *poly, rgb_color_t color) {
   }
 
   // Draw polygon with the given color
+  sdl_flush_sprites();
   filledPolygonRGBA(renderer, x_points, y_points, n, color.r * 255,
                     color.g * 255, color.b * 255, 255);
   free(x_points);
@@ -282,6 +387,11 @@ void sdl_draw_polygon(polygon_t *poly, rgb_color_t color) {
 }
 
 void sdl_show(void) {
+  if (renderer == NULL) {
+    return;
+  }
+  PROFILE_BEGIN(PROFILE_SDL_SHOW);
+  sdl_flush_sprites();
   // Draw boundary lines
   vector_t window_center = get_window_center();
   vector_t max = vec_add(center, max_diff),
@@ -299,6 +409,7 @@ void sdl_show(void) {
   free(boundary);
 
   SDL_RenderPresent(renderer);
+  PROFILE_END(PROFILE_SDL_SHOW);
 }
 
 void sdl_render_scene(scene_t *scene, void *aux) {
@@ -319,6 +430,10 @@ void sdl_render_scene(scene_t *scene, void *aux) {
 }
 
 void sdl_render_text(const char *txt, TTF_Font *font, SDL_Rect message_rect) {
+  if (renderer == NULL || font == NULL) {
+    return;
+  }
+  sdl_flush_sprites();
   SDL_Surface *surface_message = TTF_RenderText_Solid(font, txt, WHITE);
   SDL_Texture *message = SDL_CreateTextureFromSurface(renderer, surface_message);
   SDL_RenderCopy(renderer, message, NULL, &message_rect);
@@ -328,29 +443,297 @@ void sdl_render_text(const char *txt, TTF_Font *font, SDL_Rect message_rect) {
 
 void sdl_render_text_color(const char *txt, TTF_Font *font, SDL_Rect message_rect, 
                            SDL_Color color) {
-    SDL_Surface *surfaceMessage = TTF_RenderText_Solid(font, txt, color);
-    SDL_Texture *message = SDL_CreateTextureFromSurface(renderer, surfaceMessage);
-    message_rect.w = surfaceMessage->w;
-    message_rect.h = surfaceMessage->h;
-    SDL_RenderCopy(renderer, message, NULL, &message_rect);
-    SDL_FreeSurface(surfaceMessage);
+    if (renderer == NULL || font == NULL) {
+        return;
+    }
+    SDL_Texture *message = text_to_texture(txt, font, color);
+    if (message == NULL) {
+        return;
+    }
+    SDL_QueryTexture(message, NULL, NULL, &message_rect.w, &message_rect.h);
+    sdl_render_image(message, message_rect);
     SDL_DestroyTexture(message);
 }
 
 void sdl_render_image(SDL_Texture *texture, SDL_Rect image_rect) {
+  if (renderer == NULL) {
+    return;
+  }
+  sdl_flush_sprites();
   SDL_RenderCopy(renderer, texture, NULL, &image_rect);
 }
 
 void sdl_render_image_rotated(SDL_Texture *texture, SDL_Rect image_rect, double angle) {
+    if (renderer == NULL) {
+        return;
+    }
+    sdl_flush_sprites();
     // The center of rotation is the center of the image
     SDL_Point center = {image_rect.w / 2, image_rect.h / 2};
     // Render the image with the given rotation
     SDL_RenderCopyEx(renderer, texture, NULL, &image_rect, angle, &center, SDL_FLIP_NONE);
 }
 
+/**
+ * Makes room for one more sprite in the queue.
+ */
+static void queue_reserve(void) {
+  if (queue_size < queue_capacity) {
+    return;
+  }
+  size_t old_capacity = queue_capacity;
+  queue_capacity =
+      old_capacity == 0 ? RENDER_QUEUE_INITIAL_SPRITES : old_capacity * 2;
+  queue = realloc(queue, sizeof(queued_sprite_t) * queue_capacity);
+  queue_order = realloc(queue_order, sizeof(uint32_t) * queue_capacity);
+  queue_scratch = realloc(queue_scratch, sizeof(uint32_t) * queue_capacity);
+  batch_vertices =
+      realloc(batch_vertices, sizeof(SDL_Vertex) * 4 * queue_capacity);
+  batch_indices = realloc(batch_indices, sizeof(int) * 6 * queue_capacity);
+  assert(queue && queue_order && queue_scratch && batch_vertices &&
+         batch_indices);
+  // Every quad is two triangles over its own 4 vertices, so the indices
+  // never change once written
+  for (size_t quad = old_capacity; quad < queue_capacity; quad++) {
+    int first = quad * 4;
+    int *indices = &batch_indices[quad * 6];
+    indices[0] = first;
+    indices[1] = first + 1;
+    indices[2] = first + 2;
+    indices[3] = first + 2;
+    indices[4] = first + 3;
+    indices[5] = first;
+  }
+}
+
+/**
+ * Gets a texture's slot in this flush, giving it one if it has none.
+ */
+static size_t queue_texture_slot(SDL_Texture *texture) {
+  // Sprites mostly come in runs from the same texture, so check the newest
+  // slot first
+  for (size_t i = num_queue_textures; i-- > 0;) {
+    if (queue_textures[i] == texture) {
+      return i;
+    }
+  }
+  if (num_queue_textures == RENDER_QUEUE_TEXTURES) {
+    sdl_flush_sprites();
+  }
+  size_t slot = num_queue_textures++;
+  queue_textures[slot] = texture;
+  SDL_QueryTexture(texture, NULL, NULL, &queue_texture_widths[slot],
+                   &queue_texture_heights[slot]);
+  return slot;
+}
+
+void sdl_render_sprite(const sprite_t *sprite, SDL_Rect image_rect,
+                       double angle, render_layer_t layer) {
+  if (renderer == NULL || sprite->texture == NULL) {
+    return;
+  }
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  size_t slot = queue_texture_slot(sprite->texture);
+  queue_reserve();
+  queued_sprite_t *queued = &queue[queue_size++];
+  queued->key = (uint16_t)(layer << 8 | slot);
+
+  // Rotate the corners clockwise about the center, like SDL_RenderCopyEx
+  double radians = angle / DEGREES_PER_RADIAN;
+  double cos_angle = cos(radians), sin_angle = sin(radians);
+  double half_w = image_rect.w / 2.0, half_h = image_rect.h / 2.0;
+  double center_x = image_rect.x + half_w, center_y = image_rect.y + half_h;
+  const double corners[4][2] = {
+      {-half_w, -half_h}, {half_w, -half_h}, {half_w, half_h}, {-half_w, half_h}};
+
+  int texture_w = queue_texture_widths[slot];
+  int texture_h = queue_texture_heights[slot];
+  float u0 = (float)sprite->src.x / texture_w;
+  float v0 = (float)sprite->src.y / texture_h;
+  float u1 = (float)(sprite->src.x + sprite->src.w) / texture_w;
+  float v1 = (float)(sprite->src.y + sprite->src.h) / texture_h;
+  const float tex_coords[4][2] = {{u0, v0}, {u1, v0}, {u1, v1}, {u0, v1}};
+
+  for (size_t i = 0; i < 4; i++) {
+    double x = corners[i][0], y = corners[i][1];
+    queued->vertices[i] = (SDL_Vertex){
+        .position = {center_x + x * cos_angle - y * sin_angle,
+                     center_y + x * sin_angle + y * cos_angle},
+        .color = {255, 255, 255, 255},
+        .tex_coord = {tex_coords[i][0], tex_coords[i][1]}};
+  }
+#else
+  SDL_Point center = {image_rect.w / 2, image_rect.h / 2};
+  SDL_RenderCopyEx(renderer, sprite->texture, &sprite->src, &image_rect, angle,
+                   &center, SDL_FLIP_NONE);
+#endif
+}
+
+/**
+ * One stable counting sort pass over the queue, on one byte of the keys.
+ */
+static void queue_sort_pass(const uint32_t *from, uint32_t *to, int shift) {
+  size_t counts[RENDER_QUEUE_RADIX] = {0};
+  for (size_t i = 0; i < queue_size; i++) {
+    counts[(queue[from[i]].key >> shift) & 0xFF]++;
+  }
+  size_t offset = 0;
+  for (size_t digit = 0; digit < RENDER_QUEUE_RADIX; digit++) {
+    size_t count = counts[digit];
+    counts[digit] = offset;
+    offset += count;
+  }
+  for (size_t i = 0; i < queue_size; i++) {
+    to[counts[(queue[from[i]].key >> shift) & 0xFF]++] = from[i];
+  }
+}
+
+void sdl_flush_sprites(void) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  if (queue_size == 0) {
+    return;
+  }
+  // Sort by texture slot and then by layer. Both passes are stable, so the
+  // sprites end up grouped by layer, then by texture, and otherwise stay in
+  // the order they were drawn.
+  for (size_t i = 0; i < queue_size; i++) {
+    queue_scratch[i] = i;
+  }
+  queue_sort_pass(queue_scratch, queue_order, 0);
+  queue_sort_pass(queue_order, queue_scratch, 8);
+  for (size_t i = 0; i < queue_size; i++) {
+    memcpy(&batch_vertices[i * 4], queue[queue_scratch[i]].vertices,
+           sizeof(queue->vertices));
+  }
+
+  // One draw call per run of sprites from the same texture
+  size_t start = 0;
+  for (size_t i = 1; i <= queue_size; i++) {
+    size_t slot = queue[queue_scratch[start]].key & 0xFF;
+    if (i < queue_size && (queue[queue_scratch[i]].key & 0xFF) == slot) {
+      continue;
+    }
+    SDL_RenderGeometry(renderer, queue_textures[slot],
+                       &batch_vertices[start * 4], (i - start) * 4,
+                       batch_indices, (i - start) * 6);
+    start = i;
+  }
+  queue_size = 0;
+  num_queue_textures = 0;
+#endif
+}
+
+SDL_Texture *sdl_create_texture(int width, int height) {
+  if (renderer == NULL) {
+    return NULL;
+  }
+  SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32,
+                                           SDL_TEXTUREACCESS_STATIC, width,
+                                           height);
+  if (texture == NULL) {
+    return NULL;
+  }
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+  // New textures start out with undefined contents
+  void *pixels = calloc((size_t)width * height, sizeof(Uint32));
+  assert(pixels);
+  SDL_UpdateTexture(texture, NULL, pixels, width * sizeof(Uint32));
+  free(pixels);
+  return texture;
+}
+
+
+SDL_Texture *sdl_create_render_target(void) {
+  int width, height;
+  if (renderer == NULL || !SDL_RenderTargetSupported(renderer) ||
+      SDL_GetRendererOutputSize(renderer, &width, &height) != 0) {
+    return NULL;
+  }
+  SDL_Texture *texture =
+      SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32,
+                        SDL_TEXTUREACCESS_TARGET, width, height);
+  if (texture == NULL) {
+    return NULL;
+  }
+  // Blending into a cleared target leaves its colors premultiplied by alpha,
+  // so it must be drawn with premultiplied blending to look the same as
+  // drawing its contents directly
+  SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+      SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+      SDL_BLENDOPERATION_ADD, SDL_BLENDFACTOR_ONE,
+      SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+  if (SDL_SetTextureBlendMode(texture, premultiplied) != 0) {
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+  }
+  return texture;
+}
+
+void sdl_begin_render_target(SDL_Texture *target) {
+  if (renderer == NULL) {
+    return;
+  }
+  sdl_flush_sprites();
+  SDL_SetRenderTarget(renderer, target);
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+  SDL_RenderClear(renderer);
+}
+
+void sdl_end_render_target(void) {
+  if (renderer == NULL) {
+    return;
+  }
+  sdl_flush_sprites();
+  SDL_SetRenderTarget(renderer, NULL);
+}
+
+size_t sdl_get_render_target_generation(void) {
+  return render_target_generation;
+}
 
 SDL_Texture *image_to_texture(const char *file_path) {
-  return IMG_LoadTexture(renderer, file_path);
+  if (renderer == NULL) {
+    // Don't spend time decoding images that can never be drawn
+    return NULL;
+  }
+  return surface_to_texture(raw_cache_load(file_path));
+}
+
+SDL_Surface *image_to_surface(const char *file_path) {
+  if (renderer == NULL) {
+    return NULL;
+  }
+  return raw_cache_load(file_path);
+}
+
+SDL_Texture *surface_to_texture(SDL_Surface *surface) {
+  if (surface == NULL) {
+    return NULL;
+  }
+  SDL_Texture *texture =
+      renderer != NULL ? SDL_CreateTextureFromSurface(renderer, surface) : NULL;
+  SDL_FreeSurface(surface);
+  return texture;
+}
+
+SDL_Texture *text_to_texture(const char *txt, TTF_Font *font, SDL_Color color) {
+  if (renderer == NULL || font == NULL) {
+    return NULL;
+  }
+  SDL_Surface *surface = TTF_RenderText_Solid(font, txt, color);
+  if (surface == NULL) {
+    return NULL;
+  }
+  SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+  SDL_FreeSurface(surface);
+  return texture;
+}
+
+TTF_Font *load_font(const char *file_path, int size) {
+  return TTF_OpenFontRW(asset_archive_rw(file_path), 1, size);
+}
+
+int sdl_font_height(TTF_Font *font) {
+  return font == NULL ? 0 : TTF_FontHeight(font);
 }
 
 void sdl_on_key(key_handler_t handler) { key_handler = handler; }
@@ -358,16 +741,49 @@ void sdl_on_key(key_handler_t handler) { key_handler = handler; }
 void sdl_on_mouse(mouse_handler_t m_handler) { mouse_handler = m_handler; }
 
 double time_since_last_tick(void) {
-  clock_t now = clock();
-  double difference = last_clock
-                          ? (double)(now - last_clock) / CLOCKS_PER_SEC
+  double now = timer_now();
+  double difference = last_tick_time >= 0
+                          ? now - last_tick_time
                           : 0.0; // return 0 the first time this is called
-  last_clock = now;
+  last_tick_time = now;
+  if (difference > 0) {
+    timer_record_frame(difference);
+  }
   return difference;
 }
 
+void reset_tick_timer(void) { last_tick_time = timer_now(); }
+
+bool sdl_redraw_requested(void) {
+  bool requested = redraw_requested;
+  redraw_requested = false;
+  return requested;
+}
+
+void sdl_request_redraw(void) { redraw_requested = true; }
+
+void sdl_wait_event(double timeout) {
+#ifndef __EMSCRIPTEN__
+  // Leaves the event in the queue for sdl_is_done() to handle
+  SDL_WaitEventTimeout(NULL, (int)(timeout * MS_PER_S));
+#endif
+}
+
+void sdl_draw_rect(SDL_Rect rect, SDL_Color color) {
+  if (renderer == NULL) {
+    return;
+  }
+  sdl_flush_sprites();
+  SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 255);
+  SDL_RenderFillRect(renderer, &rect);
+}
+
 void sdl_draw_bar(size_t current_value, size_t max_health, SDL_Rect bar_rect, 
                   SDL_Color health_color, SDL_Color lost_color) {
+    if (renderer == NULL) {
+        return;
+    }
+    sdl_flush_sprites();
     // Calculate the width of the health portion and the lost portion
     int health_width = (int)((double)current_value / max_health * bar_rect.w);
     int lost_width = bar_rect.w - health_width;
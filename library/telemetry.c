@@ -0,0 +1,191 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+
+#include "log.h"
+#include "telemetry.h"
+#include "timer.h"
+
+// 4096 records of about 100 bytes each: a bit over a minute at 60 fps
+// per buffer, so the writer wakes up rarely
+#define TELEMETRY_BUFFER_RECORDS 4096
+
+const char *TELEMETRY_PATH = "telemetry.bin";
+
+/**
+ * The file being written, or NULL when not recording.
+ */
+static FILE *file = NULL;
+static double start_time = 0;
+static uint64_t frames_recorded = 0;
+static uint64_t ticks_recorded = 0;
+
+/**
+ * The buffer the game appends to.
+ */
+static telemetry_record_t *filling = NULL;
+static size_t num_filling = 0;
+/**
+ * The buffer handed to the writer. It belongs to the writer thread while
+ * num_flushing is nonzero.
+ */
+static telemetry_record_t *flushing = NULL;
+static size_t num_flushing = 0;
+
+/**
+ * The writer thread, or NULL if full buffers are written inline.
+ * lock guards flushing, num_flushing and stopping; ready is signaled whenever
+ * one of them changes.
+ */
+static SDL_Thread *writer = NULL;
+static SDL_mutex *lock = NULL;
+static SDL_cond *ready = NULL;
+static bool stopping = false;
+
+static void write_records(telemetry_record_t *records, size_t count) {
+  fwrite(records, sizeof(telemetry_record_t), count, file);
+}
+
+/**
+ * The writer thread: writes each buffer it is handed until told to stop.
+ */
+static int telemetry_writer(void *aux) {
+  SDL_LockMutex(lock);
+  while (true) {
+    while (num_flushing == 0 && !stopping) {
+      SDL_CondWait(ready, lock);
+    }
+    if (num_flushing == 0) {
+      break;
+    }
+
+    // The game only touches flushing once num_flushing is back to 0, so the
+    // lock isn't needed while writing
+    size_t count = num_flushing;
+    SDL_UnlockMutex(lock);
+    write_records(flushing, count);
+    SDL_LockMutex(lock);
+
+    num_flushing = 0;
+    SDL_CondBroadcast(ready);
+  }
+  SDL_UnlockMutex(lock);
+  return 0;
+}
+
+/**
+ * Hands the filled buffer to the writer and starts filling the other one,
+ * or writes the buffer inline if there is no writer.
+ */
+static void telemetry_flush(void) {
+  if (num_filling == 0) {
+    return;
+  }
+  if (writer == NULL) {
+    write_records(filling, num_filling);
+    num_filling = 0;
+    return;
+  }
+
+  SDL_LockMutex(lock);
+  // Only waits if the writer hasn't finished the previous buffer yet
+  while (num_flushing > 0) {
+    SDL_CondWait(ready, lock);
+  }
+  telemetry_record_t *full = filling;
+  filling = flushing;
+  flushing = full;
+  num_flushing = num_filling;
+  num_filling = 0;
+  SDL_CondBroadcast(ready);
+  SDL_UnlockMutex(lock);
+}
+
+void telemetry_init(void) {
+  if (file != NULL) {
+    return;
+  }
+  file = fopen(TELEMETRY_PATH, "wb");
+  if (file == NULL) {
+    LOG_ERROR("can't open %s; telemetry is off", TELEMETRY_PATH);
+    return;
+  }
+
+  telemetry_header_t header = {.version = TELEMETRY_VERSION,
+                               .record_size = sizeof(telemetry_record_t),
+                               .stage_count = PROFILE_STAGE_COUNT};
+  memcpy(header.magic, TELEMETRY_MAGIC, sizeof(header.magic));
+  for (profile_stage_t stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+    snprintf(header.stage_names[stage], TELEMETRY_STAGE_NAME_SIZE, "%s",
+             profiler_stage_name(stage));
+  }
+  fwrite(&header, sizeof(header), 1, file);
+
+  filling = malloc(sizeof(telemetry_record_t) * TELEMETRY_BUFFER_RECORDS);
+  flushing = malloc(sizeof(telemetry_record_t) * TELEMETRY_BUFFER_RECORDS);
+  assert(filling && flushing);
+  num_filling = 0;
+  num_flushing = 0;
+  frames_recorded = 0;
+  ticks_recorded = 0;
+  start_time = timer_now();
+
+#ifndef __EMSCRIPTEN__
+  lock = SDL_CreateMutex();
+  ready = SDL_CreateCond();
+  stopping = false;
+  if (lock != NULL && ready != NULL) {
+    writer = SDL_CreateThread(telemetry_writer, "telemetry", NULL);
+  }
+#endif
+}
+
+void telemetry_record(telemetry_record_t record) {
+  if (file == NULL) {
+    return;
+  }
+  record.frame = frames_recorded++;
+  record.tick = ticks_recorded;
+  record.time = timer_now() - start_time;
+  ticks_recorded += record.steps;
+
+  filling[num_filling++] = record;
+  if (num_filling == TELEMETRY_BUFFER_RECORDS) {
+    telemetry_flush();
+  }
+}
+
+void telemetry_finish(void) {
+  if (file == NULL) {
+    return;
+  }
+  telemetry_flush();
+
+  if (writer != NULL) {
+    SDL_LockMutex(lock);
+    stopping = true;
+    SDL_CondBroadcast(ready);
+    SDL_UnlockMutex(lock);
+    // The writer finishes the last buffer before it exits
+    SDL_WaitThread(writer, NULL);
+    writer = NULL;
+  }
+  if (ready != NULL) {
+    SDL_DestroyCond(ready);
+    ready = NULL;
+  }
+  if (lock != NULL) {
+    SDL_DestroyMutex(lock);
+    lock = NULL;
+  }
+
+  fclose(file);
+  file = NULL;
+  free(filling);
+  free(flushing);
+  filling = NULL;
+  flushing = NULL;
+}
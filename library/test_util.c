@@ -21,7 +21,7 @@ bool within(double epsilon, double d1, double d2) {
   return fabs(d1 - d2) < epsilon;
 }
 
-bool isclose(double d1, double d2) { return within(1e-7, d1, d2); }
+bool isclose(double d1, double d2) { return within(SCALAR_EPSILON, d1, d2); }
 
 bool vec_within(double epsilon, vector_t v1, vector_t v2) {
   return within(epsilon, v1.x, v2.x) && within(epsilon, v1.y, v2.y);
@@ -0,0 +1,83 @@
+#include <SDL2/SDL.h>
+
+#include "timer.h"
+
+#define TIMER_FRAME_WINDOW 120
+
+const double TIMER_MS_PER_S = 1e3;
+
+/**
+ * The performance counter value that timer_now() measures from,
+ * or 0 before the first call.
+ */
+static Uint64 start_counter = 0;
+/**
+ * Ticks of the performance counter per second.
+ */
+static Uint64 counter_frequency = 0;
+/**
+ * The most recent frame times, used as a ring buffer.
+ */
+static double frame_times[TIMER_FRAME_WINDOW];
+/**
+ * The total number of frames recorded; frame_times holds the last
+ * TIMER_FRAME_WINDOW of them.
+ */
+static size_t frames_recorded = 0;
+/**
+ * The value of timer_now() when timer_limit_frame() last returned,
+ * or a negative number before the first call.
+ */
+static double last_frame_end = -1;
+
+double timer_now(void) {
+  if (counter_frequency == 0) {
+    counter_frequency = SDL_GetPerformanceFrequency();
+    start_counter = SDL_GetPerformanceCounter();
+  }
+  return (double)(SDL_GetPerformanceCounter() - start_counter) /
+         counter_frequency;
+}
+
+void timer_record_frame(double frame_time) {
+  frame_times[frames_recorded % TIMER_FRAME_WINDOW] = frame_time;
+  frames_recorded++;
+}
+
+frame_stats_t timer_get_frame_stats(void) {
+  frame_stats_t stats = {0};
+  if (frames_recorded == 0) {
+    return stats;
+  }
+
+  stats.frames = frames_recorded < TIMER_FRAME_WINDOW ? frames_recorded
+                                                      : TIMER_FRAME_WINDOW;
+  stats.last = frame_times[(frames_recorded - 1) % TIMER_FRAME_WINDOW];
+  stats.min = frame_times[0];
+  stats.max = frame_times[0];
+
+  double total = 0;
+  for (size_t i = 0; i < stats.frames; i++) {
+    double frame_time = frame_times[i];
+    stats.min = frame_time < stats.min ? frame_time : stats.min;
+    stats.max = frame_time > stats.max ? frame_time : stats.max;
+    total += frame_time;
+  }
+  stats.mean = total / stats.frames;
+
+  return stats;
+}
+
+void timer_limit_frame(double max_fps) {
+#ifndef __EMSCRIPTEN__
+  double now = timer_now();
+  if (last_frame_end >= 0) {
+    double remaining = 1.0 / max_fps - (now - last_frame_end);
+    if (remaining > 0) {
+      SDL_Delay((Uint32)(remaining * TIMER_MS_PER_S));
+      now = timer_now();
+    }
+  }
+  last_frame_end = now;
+#endif
+}
@@ -0,0 +1,120 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "timer.h"
+#include "trace.h"
+
+// 8 MB of 32-byte events, over 3 minutes of frames with every stage traced.
+// Once it is full, each event overwrites the oldest one rather than growing
+// the buffer mid-frame, so the trace always ends at trace_finish(). Must be a
+// power of two.
+#define TRACE_CAPACITY (1 << 18)
+
+const char *TRACE_PATH = "trace.json";
+const double TRACE_US_PER_S = 1e6;
+
+typedef struct trace_event {
+  const char *name;
+  double time;  // From timer_now(), in seconds
+  double value; // Only used by counters
+  char phase;   // The trace-event "ph" field
+} trace_event_t;
+
+/**
+ * The recorded events as a ring buffer, or NULL when not recording.
+ * Event i is at events[i % TRACE_CAPACITY]; only the last TRACE_CAPACITY of
+ * the num_events recorded are still there.
+ */
+static trace_event_t *events = NULL;
+static size_t num_events = 0;
+
+/**
+ * Appends an event to the buffer, overwriting the oldest one if it's full.
+ */
+static void trace_record(char phase, const char *name, double time,
+                         double value) {
+  if (events == NULL) {
+    return;
+  }
+  events[num_events % TRACE_CAPACITY] =
+      (trace_event_t){.name = name, .time = time, .value = value,
+                      .phase = phase};
+  num_events++;
+}
+
+void trace_init(void) {
+  free(events);
+  events = malloc(sizeof(trace_event_t) * TRACE_CAPACITY);
+  assert(events);
+  num_events = 0;
+}
+
+void trace_begin(const char *name) {
+  trace_record('B', name, timer_now(), 0);
+}
+
+void trace_end(const char *name) { trace_record('E', name, timer_now(), 0); }
+
+void trace_counter(const char *name, double value) {
+  trace_record('C', name, timer_now(), value);
+}
+
+void trace_instant(const char *name) {
+  trace_record('i', name, timer_now(), 0);
+}
+
+void trace_span_at(char phase, const char *name, double time) {
+  trace_record(phase, name, time, 0);
+}
+
+void trace_finish(void) {
+  if (events == NULL) {
+    return;
+  }
+
+  size_t first_event =
+      num_events > TRACE_CAPACITY ? num_events - TRACE_CAPACITY : 0;
+  FILE *file = fopen(TRACE_PATH, "w");
+  if (file != NULL) {
+    fprintf(file, "{\"displayTimeUnit\": \"ms\",\n");
+    fprintf(file, " \"otherData\": {\"overwritten_events\": %zu},\n",
+            first_event);
+    fprintf(file, " \"traceEvents\": [\n");
+    // An end whose begin was overwritten would close a span that isn't in
+    // the file, so it is left out
+    size_t open_spans = 0;
+    bool first_written = true;
+    for (size_t i = first_event; i < num_events; i++) {
+      trace_event_t *event = &events[i % TRACE_CAPACITY];
+      if (event->phase == 'B') {
+        open_spans++;
+      } else if (event->phase == 'E') {
+        if (open_spans == 0) {
+          continue;
+        }
+        open_spans--;
+      }
+
+      fprintf(file,
+              "%s  {\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, "
+              "\"pid\": 1, \"tid\": 1",
+              first_written ? "" : ",\n", event->name, event->phase,
+              event->time * TRACE_US_PER_S);
+      if (event->phase == 'C') {
+        fprintf(file, ", \"args\": {\"value\": %g}", event->value);
+      } else if (event->phase == 'i') {
+        // Draw instant events across the whole timeline
+        fprintf(file, ", \"s\": \"g\"");
+      }
+      fprintf(file, "}");
+      first_written = false;
+    }
+    fprintf(file, "\n ]}\n");
+    fclose(file);
+  }
+
+  free(events);
+  events = NULL;
+}
@@ -3,7 +3,7 @@
  */
 
 #include "vector.h"
-#include "math.h"
+#include <tgmath.h>
 
 const vector_t VEC_ZERO = {0.0, 0.0};
 
@@ -30,46 +30,48 @@ vector_t vec_negate(vector_t v) {
   return v;
 }
 
-vector_t vec_multiply(double scalar, vector_t v) {
+vector_t vec_multiply(scalar_t scalar, vector_t v) {
   v.x *= scalar;
   v.y *= scalar;
 
   return v;
 }
 
-double vec_dot(vector_t v1, vector_t v2) {
+scalar_t vec_dot(vector_t v1, vector_t v2) {
   // Using definition of dot product
   return v1.x * v2.x + v1.y * v2.y;
 }
 
-double vec_cross(vector_t v1, vector_t v2) {
+scalar_t vec_cross(vector_t v1, vector_t v2) {
   // Using definition of cross product
   return v1.x * v2.y - v1.y * v2.x;
 }
 
-double vec_get_length(vector_t v) { return sqrt(pow(v.x, 2) + pow(v.y, 2)); }
+scalar_t vec_get_length(vector_t v) { return sqrt(v.x * v.x + v.y * v.y); }
 
-vector_t vec_rotate(vector_t v, double angle) {
+vector_t vec_rotate(vector_t v, scalar_t angle) {
   vector_t resultant_vector = VEC_ZERO;
+  scalar_t c = cos(angle);
+  scalar_t s = sin(angle);
 
-  resultant_vector.x = (v.x * cos(angle)) - (v.y * sin(angle));
-  resultant_vector.y = (v.x * sin(angle)) + (v.y * cos(angle));
+  resultant_vector.x = (v.x * c) - (v.y * s);
+  resultant_vector.y = (v.x * s) + (v.y * c);
 
   return resultant_vector;
 }
 
-double vec_angle_between(vector_t v1, vector_t v2) {
-    double dot = vec_dot(v1, v2);
-    double len1 = vec_get_length(v1);
-    double len2 = vec_get_length(v2);
+scalar_t vec_angle_between(vector_t v1, vector_t v2) {
+    scalar_t dot = vec_dot(v1, v2);
+    scalar_t len1 = vec_get_length(v1);
+    scalar_t len2 = vec_get_length(v2);
 
     // Error checking
     if (len1 == 0 || len2 == 0) {
         return 0;
     }
 
-    double cos_theta = dot / (len1 * len2);
-    cos_theta = fmax(fmin(cos_theta, 1), -1);
+    scalar_t cos_theta = dot / (len1 * len2);
+    cos_theta = fmax(fmin(cos_theta, (scalar_t)1), (scalar_t)-1);
 
     // Return the angle in radians
     return acos(cos_theta);
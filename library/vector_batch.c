@@ -0,0 +1,406 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <tgmath.h>
+
+#include "vector_batch.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__EMSCRIPTEN__)
+#define VEC_BATCH_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * The set of kernels for one instruction set. The SIMD kernels process as
+ * many whole registers as they can and hand the remainder to the scalar ones.
+ */
+typedef struct {
+  const char *name;
+  void (*translate)(scalar_t *x, scalar_t *y, size_t n, scalar_t tx,
+                    scalar_t ty);
+  void (*rotate)(scalar_t *x, scalar_t *y, size_t n, scalar_t c, scalar_t s,
+                 scalar_t px, scalar_t py);
+  // max and min are running accumulators, updated in place
+  void (*project)(const scalar_t *x, const scalar_t *y, size_t n, scalar_t ax,
+                  scalar_t ay, scalar_t *max, scalar_t *min);
+  void (*length)(const scalar_t *x, const scalar_t *y, size_t n,
+                 scalar_t *lengths);
+  void (*normalize)(scalar_t *x, scalar_t *y, size_t n);
+} kernels_t;
+
+static void scalar_translate(scalar_t *x, scalar_t *y, size_t n, scalar_t tx,
+                             scalar_t ty) {
+  for (size_t i = 0; i < n; i++) {
+    x[i] += tx;
+    y[i] += ty;
+  }
+}
+
+static void scalar_rotate(scalar_t *x, scalar_t *y, size_t n, scalar_t c,
+                          scalar_t s, scalar_t px, scalar_t py) {
+  for (size_t i = 0; i < n; i++) {
+    scalar_t dx = x[i] - px;
+    scalar_t dy = y[i] - py;
+    x[i] = dx * c - dy * s + px;
+    y[i] = dx * s + dy * c + py;
+  }
+}
+
+static void scalar_project(const scalar_t *x, const scalar_t *y, size_t n,
+                           scalar_t ax, scalar_t ay, scalar_t *max,
+                           scalar_t *min) {
+  for (size_t i = 0; i < n; i++) {
+    scalar_t projection = x[i] * ax + y[i] * ay;
+    *max = projection > *max ? projection : *max;
+    *min = projection < *min ? projection : *min;
+  }
+}
+
+static void scalar_length(const scalar_t *x, const scalar_t *y, size_t n,
+                          scalar_t *lengths) {
+  for (size_t i = 0; i < n; i++) {
+    lengths[i] = sqrt(x[i] * x[i] + y[i] * y[i]);
+  }
+}
+
+static void scalar_normalize(scalar_t *x, scalar_t *y, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    scalar_t length = sqrt(x[i] * x[i] + y[i] * y[i]);
+    if (length != 0) {
+      x[i] /= length;
+      y[i] /= length;
+    }
+  }
+}
+
+static const kernels_t SCALAR_KERNELS = {
+    .name = "scalar",
+    .translate = scalar_translate,
+    .rotate = scalar_rotate,
+    .project = scalar_project,
+    .length = scalar_length,
+    .normalize = scalar_normalize,
+};
+
+#ifdef VEC_BATCH_X86
+
+// Map the generic register operations onto the intrinsics for scalar_t
+#ifdef VECTOR_SINGLE_PRECISION
+#define SSE_T __m128
+#define SSE_WIDTH 4
+#define SSE_LOAD _mm_loadu_ps
+#define SSE_STORE _mm_storeu_ps
+#define SSE_SET1 _mm_set1_ps
+#define SSE_ADD _mm_add_ps
+#define SSE_SUB _mm_sub_ps
+#define SSE_MUL _mm_mul_ps
+#define SSE_DIV _mm_div_ps
+#define SSE_MIN _mm_min_ps
+#define SSE_MAX _mm_max_ps
+#define SSE_SQRT _mm_sqrt_ps
+#define SSE_AND _mm_and_ps
+#define SSE_NONZERO(v) _mm_cmpneq_ps(v, _mm_setzero_ps())
+#define AVX_T __m256
+#define AVX_WIDTH 8
+#define AVX_LOAD _mm256_loadu_ps
+#define AVX_STORE _mm256_storeu_ps
+#define AVX_SET1 _mm256_set1_ps
+#define AVX_ADD _mm256_add_ps
+#define AVX_SUB _mm256_sub_ps
+#define AVX_MUL _mm256_mul_ps
+#define AVX_DIV _mm256_div_ps
+#define AVX_MIN _mm256_min_ps
+#define AVX_MAX _mm256_max_ps
+#define AVX_SQRT _mm256_sqrt_ps
+#define AVX_AND _mm256_and_ps
+#define AVX_NONZERO(v) _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_NEQ_OQ)
+#else
+#define SSE_T __m128d
+#define SSE_WIDTH 2
+#define SSE_LOAD _mm_loadu_pd
+#define SSE_STORE _mm_storeu_pd
+#define SSE_SET1 _mm_set1_pd
+#define SSE_ADD _mm_add_pd
+#define SSE_SUB _mm_sub_pd
+#define SSE_MUL _mm_mul_pd
+#define SSE_DIV _mm_div_pd
+#define SSE_MIN _mm_min_pd
+#define SSE_MAX _mm_max_pd
+#define SSE_SQRT _mm_sqrt_pd
+#define SSE_AND _mm_and_pd
+#define SSE_NONZERO(v) _mm_cmpneq_pd(v, _mm_setzero_pd())
+#define AVX_T __m256d
+#define AVX_WIDTH 4
+#define AVX_LOAD _mm256_loadu_pd
+#define AVX_STORE _mm256_storeu_pd
+#define AVX_SET1 _mm256_set1_pd
+#define AVX_ADD _mm256_add_pd
+#define AVX_SUB _mm256_sub_pd
+#define AVX_MUL _mm256_mul_pd
+#define AVX_DIV _mm256_div_pd
+#define AVX_MIN _mm256_min_pd
+#define AVX_MAX _mm256_max_pd
+#define AVX_SQRT _mm256_sqrt_pd
+#define AVX_AND _mm256_and_pd
+#define AVX_NONZERO(v) _mm256_cmp_pd(v, _mm256_setzero_pd(), _CMP_NEQ_OQ)
+#endif
+
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+SSE2_TARGET static void sse2_translate(scalar_t *x, scalar_t *y, size_t n,
+                                       scalar_t tx, scalar_t ty) {
+  SSE_T vtx = SSE_SET1(tx), vty = SSE_SET1(ty);
+  size_t i = 0;
+  for (; i + SSE_WIDTH <= n; i += SSE_WIDTH) {
+    SSE_STORE(x + i, SSE_ADD(SSE_LOAD(x + i), vtx));
+    SSE_STORE(y + i, SSE_ADD(SSE_LOAD(y + i), vty));
+  }
+  scalar_translate(x + i, y + i, n - i, tx, ty);
+}
+
+SSE2_TARGET static void sse2_rotate(scalar_t *x, scalar_t *y, size_t n,
+                                    scalar_t c, scalar_t s, scalar_t px,
+                                    scalar_t py) {
+  SSE_T vc = SSE_SET1(c), vs = SSE_SET1(s);
+  SSE_T vpx = SSE_SET1(px), vpy = SSE_SET1(py);
+  size_t i = 0;
+  for (; i + SSE_WIDTH <= n; i += SSE_WIDTH) {
+    SSE_T dx = SSE_SUB(SSE_LOAD(x + i), vpx);
+    SSE_T dy = SSE_SUB(SSE_LOAD(y + i), vpy);
+    SSE_STORE(x + i, SSE_ADD(SSE_SUB(SSE_MUL(dx, vc), SSE_MUL(dy, vs)), vpx));
+    SSE_STORE(y + i, SSE_ADD(SSE_ADD(SSE_MUL(dx, vs), SSE_MUL(dy, vc)), vpy));
+  }
+  scalar_rotate(x + i, y + i, n - i, c, s, px, py);
+}
+
+SSE2_TARGET static void sse2_project(const scalar_t *x, const scalar_t *y,
+                                     size_t n, scalar_t ax, scalar_t ay,
+                                     scalar_t *max, scalar_t *min) {
+  SSE_T vax = SSE_SET1(ax), vay = SSE_SET1(ay);
+  SSE_T vmax = SSE_SET1(*max), vmin = SSE_SET1(*min);
+  size_t i = 0;
+  for (; i + SSE_WIDTH <= n; i += SSE_WIDTH) {
+    SSE_T projection = SSE_ADD(SSE_MUL(SSE_LOAD(x + i), vax),
+                               SSE_MUL(SSE_LOAD(y + i), vay));
+    vmax = SSE_MAX(vmax, projection);
+    vmin = SSE_MIN(vmin, projection);
+  }
+
+  scalar_t lanes_max[SSE_WIDTH], lanes_min[SSE_WIDTH];
+  SSE_STORE(lanes_max, vmax);
+  SSE_STORE(lanes_min, vmin);
+  for (size_t lane = 0; lane < SSE_WIDTH; lane++) {
+    *max = lanes_max[lane] > *max ? lanes_max[lane] : *max;
+    *min = lanes_min[lane] < *min ? lanes_min[lane] : *min;
+  }
+  scalar_project(x + i, y + i, n - i, ax, ay, max, min);
+}
+
+SSE2_TARGET static void sse2_length(const scalar_t *x, const scalar_t *y,
+                                    size_t n, scalar_t *lengths) {
+  size_t i = 0;
+  for (; i + SSE_WIDTH <= n; i += SSE_WIDTH) {
+    SSE_T vx = SSE_LOAD(x + i), vy = SSE_LOAD(y + i);
+    SSE_STORE(lengths + i, SSE_SQRT(SSE_ADD(SSE_MUL(vx, vx), SSE_MUL(vy, vy))));
+  }
+  scalar_length(x + i, y + i, n - i, lengths + i);
+}
+
+SSE2_TARGET static void sse2_normalize(scalar_t *x, scalar_t *y, size_t n) {
+  size_t i = 0;
+  for (; i + SSE_WIDTH <= n; i += SSE_WIDTH) {
+    SSE_T vx = SSE_LOAD(x + i), vy = SSE_LOAD(y + i);
+    SSE_T length = SSE_SQRT(SSE_ADD(SSE_MUL(vx, vx), SSE_MUL(vy, vy)));
+    // Lanes with zero length divide to NaN; the mask turns them back into 0
+    SSE_T nonzero = SSE_NONZERO(length);
+    SSE_STORE(x + i, SSE_AND(nonzero, SSE_DIV(vx, length)));
+    SSE_STORE(y + i, SSE_AND(nonzero, SSE_DIV(vy, length)));
+  }
+  scalar_normalize(x + i, y + i, n - i);
+}
+
+AVX2_TARGET static void avx2_translate(scalar_t *x, scalar_t *y, size_t n,
+                                       scalar_t tx, scalar_t ty) {
+  AVX_T vtx = AVX_SET1(tx), vty = AVX_SET1(ty);
+  size_t i = 0;
+  for (; i + AVX_WIDTH <= n; i += AVX_WIDTH) {
+    AVX_STORE(x + i, AVX_ADD(AVX_LOAD(x + i), vtx));
+    AVX_STORE(y + i, AVX_ADD(AVX_LOAD(y + i), vty));
+  }
+  sse2_translate(x + i, y + i, n - i, tx, ty);
+}
+
+AVX2_TARGET static void avx2_rotate(scalar_t *x, scalar_t *y, size_t n,
+                                    scalar_t c, scalar_t s, scalar_t px,
+                                    scalar_t py) {
+  AVX_T vc = AVX_SET1(c), vs = AVX_SET1(s);
+  AVX_T vpx = AVX_SET1(px), vpy = AVX_SET1(py);
+  size_t i = 0;
+  for (; i + AVX_WIDTH <= n; i += AVX_WIDTH) {
+    AVX_T dx = AVX_SUB(AVX_LOAD(x + i), vpx);
+    AVX_T dy = AVX_SUB(AVX_LOAD(y + i), vpy);
+    AVX_STORE(x + i, AVX_ADD(AVX_SUB(AVX_MUL(dx, vc), AVX_MUL(dy, vs)), vpx));
+    AVX_STORE(y + i, AVX_ADD(AVX_ADD(AVX_MUL(dx, vs), AVX_MUL(dy, vc)), vpy));
+  }
+  sse2_rotate(x + i, y + i, n - i, c, s, px, py);
+}
+
+AVX2_TARGET static void avx2_project(const scalar_t *x, const scalar_t *y,
+                                     size_t n, scalar_t ax, scalar_t ay,
+                                     scalar_t *max, scalar_t *min) {
+  AVX_T vax = AVX_SET1(ax), vay = AVX_SET1(ay);
+  AVX_T vmax = AVX_SET1(*max), vmin = AVX_SET1(*min);
+  size_t i = 0;
+  for (; i + AVX_WIDTH <= n; i += AVX_WIDTH) {
+    AVX_T projection = AVX_ADD(AVX_MUL(AVX_LOAD(x + i), vax),
+                               AVX_MUL(AVX_LOAD(y + i), vay));
+    vmax = AVX_MAX(vmax, projection);
+    vmin = AVX_MIN(vmin, projection);
+  }
+
+  scalar_t lanes_max[AVX_WIDTH], lanes_min[AVX_WIDTH];
+  AVX_STORE(lanes_max, vmax);
+  AVX_STORE(lanes_min, vmin);
+  for (size_t lane = 0; lane < AVX_WIDTH; lane++) {
+    *max = lanes_max[lane] > *max ? lanes_max[lane] : *max;
+    *min = lanes_min[lane] < *min ? lanes_min[lane] : *min;
+  }
+  sse2_project(x + i, y + i, n - i, ax, ay, max, min);
+}
+
+AVX2_TARGET static void avx2_length(const scalar_t *x, const scalar_t *y,
+                                    size_t n, scalar_t *lengths) {
+  size_t i = 0;
+  for (; i + AVX_WIDTH <= n; i += AVX_WIDTH) {
+    AVX_T vx = AVX_LOAD(x + i), vy = AVX_LOAD(y + i);
+    AVX_STORE(lengths + i, AVX_SQRT(AVX_ADD(AVX_MUL(vx, vx), AVX_MUL(vy, vy))));
+  }
+  sse2_length(x + i, y + i, n - i, lengths + i);
+}
+
+AVX2_TARGET static void avx2_normalize(scalar_t *x, scalar_t *y, size_t n) {
+  size_t i = 0;
+  for (; i + AVX_WIDTH <= n; i += AVX_WIDTH) {
+    AVX_T vx = AVX_LOAD(x + i), vy = AVX_LOAD(y + i);
+    AVX_T length = AVX_SQRT(AVX_ADD(AVX_MUL(vx, vx), AVX_MUL(vy, vy)));
+    AVX_T nonzero = AVX_NONZERO(length);
+    AVX_STORE(x + i, AVX_AND(nonzero, AVX_DIV(vx, length)));
+    AVX_STORE(y + i, AVX_AND(nonzero, AVX_DIV(vy, length)));
+  }
+  sse2_normalize(x + i, y + i, n - i);
+}
+
+static const kernels_t SSE2_KERNELS = {
+    .name = "sse2",
+    .translate = sse2_translate,
+    .rotate = sse2_rotate,
+    .project = sse2_project,
+    .length = sse2_length,
+    .normalize = sse2_normalize,
+};
+
+static const kernels_t AVX2_KERNELS = {
+    .name = "avx2",
+    .translate = avx2_translate,
+    .rotate = avx2_rotate,
+    .project = avx2_project,
+    .length = avx2_length,
+    .normalize = avx2_normalize,
+};
+
+#endif // #ifdef VEC_BATCH_X86
+
+/**
+ * The kernels selected for this CPU. Only written by select_kernels(), before
+ * main() runs, so every thread sees the same value without locking.
+ */
+static const kernels_t *kernels = &SCALAR_KERNELS;
+
+/**
+ * Picks the fastest set of kernels the CPU supports. Runs once as the program
+ * is loaded, so the kernel calls only ever read `kernels`.
+ */
+__attribute__((constructor)) static void select_kernels(void) {
+#ifdef VEC_BATCH_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    kernels = &AVX2_KERNELS;
+  } else if (__builtin_cpu_supports("sse2")) {
+    kernels = &SSE2_KERNELS;
+  }
+#endif
+}
+
+void vec_batch_init(vec_batch_t *batch, size_t size) {
+  batch->size = size;
+  if (size <= VEC_BATCH_INLINE) {
+    batch->x = batch->inline_x;
+    batch->y = batch->inline_y;
+  } else {
+    batch->x = malloc(size * sizeof(scalar_t));
+    batch->y = malloc(size * sizeof(scalar_t));
+    assert(batch->x);
+    assert(batch->y);
+  }
+}
+
+void vec_batch_from_list(vec_batch_t *batch, list_t *points) {
+  size_t size = list_size(points);
+  vec_batch_init(batch, size);
+  for (size_t i = 0; i < size; i++) {
+    vector_t *point = list_get(points, i);
+    batch->x[i] = point->x;
+    batch->y[i] = point->y;
+  }
+}
+
+void vec_batch_to_list(vec_batch_t *batch, list_t *points) {
+  assert(list_size(points) == batch->size);
+  for (size_t i = 0; i < batch->size; i++) {
+    vector_t *point = list_get(points, i);
+    point->x = batch->x[i];
+    point->y = batch->y[i];
+  }
+}
+
+void vec_batch_release(vec_batch_t *batch) {
+  if (batch->x != batch->inline_x) {
+    free(batch->x);
+    free(batch->y);
+  }
+  batch->x = NULL;
+  batch->y = NULL;
+  batch->size = 0;
+}
+
+void vec_batch_translate(scalar_t *x, scalar_t *y, size_t n,
+                         vector_t translation) {
+  kernels->translate(x, y, n, translation.x, translation.y);
+}
+
+void vec_batch_rotate(scalar_t *x, scalar_t *y, size_t n, scalar_t angle,
+                      vector_t pivot) {
+  scalar_t c = cos(angle);
+  scalar_t s = sin(angle);
+  kernels->rotate(x, y, n, c, s, pivot.x, pivot.y);
+}
+
+vector_t vec_batch_project_max_min(const scalar_t *x, const scalar_t *y,
+                                   size_t n, vector_t axis) {
+  assert(n > 0);
+  scalar_t max = x[0] * axis.x + y[0] * axis.y;
+  scalar_t min = max;
+  kernels->project(x + 1, y + 1, n - 1, axis.x, axis.y, &max, &min);
+  return (vector_t){.x = max, .y = min};
+}
+
+void vec_batch_length(const scalar_t *x, const scalar_t *y, size_t n,
+                      scalar_t *lengths) {
+  kernels->length(x, y, n, lengths);
+}
+
+void vec_batch_normalize(scalar_t *x, scalar_t *y, size_t n) {
+  kernels->normalize(x, y, n);
+}
+
+const char *vec_batch_backend(void) { return kernels->name; }
@@ -0,0 +1,128 @@
+// Checks the places where single-precision physics depends on exactness.
+// Built with -DVECTOR_SINGLE_PRECISION (see "make test"), so scalar_t is float.
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "body.h"
+#include "forces.h"
+#include "test_util.h"
+
+// The game's arena runs from (0, 0) to (1000, 500)
+const float ARENA_MAX_COORD = 1000;
+const size_t ROUND_TRIP_STEPS = 1000;
+
+static_assert(sizeof(scalar_t) == sizeof(float),
+              "this suite must be built with -DVECTOR_SINGLE_PRECISION");
+
+/**
+ * Makes a 1 x 1 square body centered at `center`.
+ */
+static body_t *make_square(vector_t center, scalar_t mass) {
+  list_t *shape = list_init(4, free);
+  const vector_t corners[] = {{-0.5, -0.5}, {0.5, -0.5}, {0.5, 0.5}, {-0.5, 0.5}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *corner = malloc(sizeof(vector_t));
+    assert(corner);
+    *corner = vec_add(center, corners[i]);
+    list_add(shape, corner);
+  }
+  return body_init(shape, mass, (rgb_color_t){0, 0, 0});
+}
+
+/**
+ * Bounces a body off a wall of mass INFINITY with elasticity `elasticity`,
+ * with the wall passed as the first or second body.
+ */
+static void bounce_off_wall(bool wall_first, scalar_t elasticity) {
+  body_t *ball = make_square((vector_t){10, 10}, 2);
+  body_t *wall = make_square((vector_t){11, 10}, INFINITY);
+  body_set_velocity(ball, (vector_t){3, 0});
+
+  vector_t axis = {1, 0};
+  if (wall_first) {
+    physics_collision_handler(wall, ball, vec_negate(axis), NULL, elasticity);
+  } else {
+    physics_collision_handler(ball, wall, axis, NULL, elasticity);
+  }
+  body_tick(ball, 0);
+  body_tick(wall, 0);
+
+  // The ball keeps all its speed along the axis times the elasticity, and the
+  // wall, whose reduced mass is the ball's, doesn't move or turn into NaN
+  assert(vec_isclose(body_get_velocity(ball), (vector_t){-3 * elasticity, 0}));
+  assert(vec_equal(body_get_velocity(wall), VEC_ZERO));
+  assert(vec_isclose(body_get_centroid(wall), (vector_t){11, 10}));
+
+  body_free(ball);
+  body_free(wall);
+}
+
+void test_infinite_mass_collision() {
+  bounce_off_wall(false, 1);
+  bounce_off_wall(true, 1);
+  bounce_off_wall(false, 0.5);
+  bounce_off_wall(true, 0.5);
+}
+
+void test_finite_mass_collision() {
+  // Equal masses swap velocities in a perfectly elastic collision
+  body_t *body1 = make_square((vector_t){10, 10}, 2);
+  body_t *body2 = make_square((vector_t){11, 10}, 2);
+  body_set_velocity(body1, (vector_t){3, 0});
+  physics_collision_handler(body1, body2, (vector_t){1, 0}, NULL, 1);
+  body_tick(body1, 0);
+  body_tick(body2, 0);
+  assert(vec_isclose(body_get_velocity(body1), VEC_ZERO));
+  assert(vec_isclose(body_get_velocity(body2), (vector_t){3, 0}));
+  body_free(body1);
+  body_free(body2);
+}
+
+void test_epsilon_covers_arena_rounding() {
+  // Floats are spaced 2^-14 (about 6.1e-5) apart between 512 and 1024, the
+  // coarsest anywhere in the arena. SCALAR_EPSILON must be above that, or
+  // positions one rounding apart would not compare as close.
+  for (float coord = 1; coord <= ARENA_MAX_COORD; coord *= 2) {
+    float next = nextafterf(coord, INFINITY);
+    assert(next - coord < SCALAR_EPSILON);
+    assert(isclose(coord, next));
+  }
+  float top = ARENA_MAX_COORD;
+  assert(nextafterf(top, INFINITY) - top < SCALAR_EPSILON);
+
+  // Moving a point there and back rounds twice, by at most half a spacing each
+  // time, so it always comes back within SCALAR_EPSILON of where it started
+  vector_t start = {ARENA_MAX_COORD - 0.3, ARENA_MAX_COORD / 2 + 0.7};
+  for (size_t i = 1; i <= ROUND_TRIP_STEPS; i++) {
+    vector_t step = {i * 0.0137f, -(scalar_t)i * 0.0291f};
+    vector_t moved = vec_subtract(vec_add(start, step), step);
+    assert(vec_isclose(moved, start));
+  }
+
+  // The double build's epsilon of 1e-7 would reject a single rounding here
+  float coord = ARENA_MAX_COORD;
+  assert(!within(1e-7, coord, nextafterf(coord, INFINITY)));
+
+  // But SCALAR_EPSILON still tells apart positions a thousandth of a unit
+  // apart, far below a pixel
+  assert(!isclose(ARENA_MAX_COORD, ARENA_MAX_COORD + 1e-3f));
+  assert(!vec_isclose((vector_t){500, 250}, (vector_t){500, 250.001f}));
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_infinite_mass_collision)
+  DO_TEST(test_finite_mass_collision)
+  DO_TEST(test_epsilon_covers_arena_rounding)
+
+  puts("test_suite_scalar PASS");
+}
@@ -0,0 +1,65 @@
+// Checks that switching scenes lets the asset cache free the backgrounds of
+// the scene that ended. Drives the whole game with SDL's dummy video and
+// audio drivers, so it needs no display, and must run from the repository
+// root so the assets can be found.
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "asset_cache.h"
+#include "game.h"
+#include "state.h"
+#include "test_util.h"
+
+// Smaller than any image, so every image nothing references is evicted
+const size_t TIGHT_BUDGET = 1;
+const double SETTLE_PUMP_TIME = 0.1;
+
+/**
+ * Uploads every image still being decoded, then evicts whatever nothing
+ * references, so only the images the current scene holds stay loaded.
+ */
+static void settle(void) {
+  while (asset_cache_get_pending() > 0) {
+    asset_cache_pump(SETTLE_PUMP_TIME);
+  }
+  // Images are only evicted when one is released or the budget is set, so
+  // the last one uploaded above may still be loaded until now
+  asset_cache_set_budget(TIGHT_BUDGET);
+}
+
+static void test_switch_frees_previous_background(void) {
+  state_t *state = emscripten_init();
+  settle();
+  size_t menu_bytes = asset_cache_get_texture_bytes();
+  assert(menu_bytes > 0);
+
+  // The start screen (1998 x 999) is bigger than the overworld and the
+  // interface border (1250 x 625 each) together, so the game scene only
+  // takes less than the menu if the start screen was freed
+  play(state);
+  settle();
+  size_t game_bytes = asset_cache_get_texture_bytes();
+  assert(game_bytes > 0);
+  assert(game_bytes < menu_bytes);
+
+  emscripten_free(state);
+}
+
+int main(int argc, char *argv[]) {
+  // Don't replace drivers the caller picked, e.g. to watch the test run
+  setenv("SDL_VIDEODRIVER", "dummy", false);
+  setenv("SDL_AUDIODRIVER", "dummy", false);
+
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_switch_frees_previous_background)
+
+  puts("test_suite_scene_budget PASS");
+}
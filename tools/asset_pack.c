@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "asset_archive.h"
+
+/**
+ * Packs asset files into one archive for asset_archive.c. Each file is
+ * stored under the path it was given on the command line, which must be the
+ * path the game loads it by.
+ *
+ * Usage: bin/asset_pack assets.pack <files>, e.g. every file in assets/
+ */
+
+typedef struct packed_file {
+  const char *path;
+  asset_archive_entry_t entry;
+} packed_file_t;
+
+static int compare_files(const void *a, const void *b) {
+  const packed_file_t *file_a = a;
+  const packed_file_t *file_b = b;
+  if (file_a->entry.hash != file_b->entry.hash) {
+    return file_a->entry.hash < file_b->entry.hash ? -1 : 1;
+  }
+  return strcmp(file_a->path, file_b->path);
+}
+
+static uint64_t align(uint64_t offset) {
+  return (offset + ASSET_ARCHIVE_ALIGNMENT - 1) /
+         ASSET_ARCHIVE_ALIGNMENT * ASSET_ARCHIVE_ALIGNMENT;
+}
+
+/**
+ * Copies a whole file to the end of the archive.
+ *
+ * @return true if exactly `size` bytes were copied
+ */
+static bool copy_file(const char *path, uint64_t size, FILE *out) {
+  FILE *in = fopen(path, "rb");
+  if (in == NULL) {
+    return false;
+  }
+  char buffer[1 << 16];
+  uint64_t copied = 0;
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    fwrite(buffer, 1, read, out);
+    copied += read;
+  }
+  fclose(in);
+  return copied == size;
+}
+
+static void pad(FILE *out, uint64_t offset) {
+  while ((uint64_t)ftell(out) < offset) {
+    fputc(0, out);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s assets.pack file...\n", argv[0]);
+    return 1;
+  }
+  size_t count = argc - 2;
+  packed_file_t *files = calloc(count, sizeof(packed_file_t));
+  if (files == NULL) {
+    return 1;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    const char *path = argv[i + 2];
+    FILE *in = fopen(path, "rb");
+    if (in == NULL || fseek(in, 0, SEEK_END) != 0) {
+      fprintf(stderr, "can't read %s\n", path);
+      return 1;
+    }
+    files[i].path = path;
+    files[i].entry.hash = asset_archive_hash(path);
+    files[i].entry.size = ftell(in);
+    files[i].entry.path_size = strlen(path);
+    fclose(in);
+  }
+  qsort(files, count, sizeof(packed_file_t), compare_files);
+
+  // Lay out the paths right after the index, then each file on an aligned
+  // offset after them
+  uint64_t offset = sizeof(asset_archive_header_t) +
+                    count * sizeof(asset_archive_entry_t);
+  for (size_t i = 0; i < count; i++) {
+    files[i].entry.path_offset = offset;
+    offset += files[i].entry.path_size;
+  }
+  for (size_t i = 0; i < count; i++) {
+    offset = align(offset);
+    files[i].entry.offset = offset;
+    offset += files[i].entry.size;
+  }
+
+  FILE *out = fopen(argv[1], "wb");
+  if (out == NULL) {
+    fprintf(stderr, "can't open %s\n", argv[1]);
+    return 1;
+  }
+  asset_archive_header_t header = {.version = ASSET_ARCHIVE_VERSION,
+                                   .count = count};
+  memcpy(header.magic, ASSET_ARCHIVE_MAGIC, sizeof(header.magic));
+  fwrite(&header, sizeof(header), 1, out);
+  for (size_t i = 0; i < count; i++) {
+    fwrite(&files[i].entry, sizeof(asset_archive_entry_t), 1, out);
+  }
+  for (size_t i = 0; i < count; i++) {
+    fwrite(files[i].path, 1, files[i].entry.path_size, out);
+  }
+  for (size_t i = 0; i < count; i++) {
+    pad(out, files[i].entry.offset);
+    if (!copy_file(files[i].path, files[i].entry.size, out)) {
+      fprintf(stderr, "%s changed while it was being packed\n", files[i].path);
+      fclose(out);
+      remove(argv[1]);
+      return 1;
+    }
+  }
+  fclose(out);
+
+  fprintf(stderr, "%zu files, %llu bytes\n", count, (unsigned long long)offset);
+  free(files);
+  return 0;
+}
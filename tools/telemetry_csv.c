@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "telemetry.h"
+
+/**
+ * Converts a telemetry.bin written by a -DTELEMETRY build into a CSV with
+ * one row per frame. Stage timings are written in milliseconds.
+ *
+ * Usage: bin/telemetry_csv telemetry.bin > telemetry.csv
+ */
+
+const double TELEMETRY_MS_PER_S = 1e3;
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s telemetry.bin > telemetry.csv\n", argv[0]);
+    return 1;
+  }
+  FILE *in = fopen(argv[1], "rb");
+  if (in == NULL) {
+    fprintf(stderr, "can't open %s\n", argv[1]);
+    return 1;
+  }
+
+  telemetry_header_t header;
+  if (fread(&header, sizeof(header), 1, in) != 1 ||
+      memcmp(header.magic, TELEMETRY_MAGIC, sizeof(header.magic)) != 0) {
+    fprintf(stderr, "%s isn't a telemetry file\n", argv[1]);
+    fclose(in);
+    return 1;
+  }
+  if (header.version != TELEMETRY_VERSION ||
+      header.record_size != sizeof(telemetry_record_t) ||
+      header.stage_count != PROFILE_STAGE_COUNT) {
+    fprintf(stderr,
+            "%s was written by a different build (version %u, %u-byte "
+            "records, %u stages)\n",
+            argv[1], header.version, header.record_size, header.stage_count);
+    fclose(in);
+    return 1;
+  }
+
+  printf("frame,tick,time,dt,steps,bodies,projectiles,enemies,force_creators,"
+         "assets,player_health,player_exp,player_level,boss_health");
+  for (size_t stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+    printf(",%.*s_ms", TELEMETRY_STAGE_NAME_SIZE, header.stage_names[stage]);
+  }
+  printf("\n");
+
+  telemetry_record_t record;
+  size_t rows = 0;
+  while (fread(&record, sizeof(record), 1, in) == 1) {
+    printf("%llu,%llu,%.6f,%.6f,%u,%u,%u,%u,%u,%u,%u,%u,%u,%d",
+           (unsigned long long)record.frame, (unsigned long long)record.tick,
+           record.time, record.dt, record.steps, record.bodies,
+           record.projectiles, record.enemies, record.force_creators,
+           record.assets, record.player_health, record.player_exp,
+           record.player_level, record.boss_health);
+    for (size_t stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+      printf(",%.4f", record.stages[stage] * TELEMETRY_MS_PER_S);
+    }
+    printf("\n");
+    rows++;
+  }
+  fclose(in);
+
+  fprintf(stderr, "%zu frames\n", rows);
+  return 0;
+}